@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BPlusTree.h"
+
+/**
+ * 随机插入、删除、pop_min，与 std::map 比较，最后比较完整遍历和区间扫描的结果。
+ */
+void TestBPlusTree() {
+  BPlusTree<uint64_t, uint64_t> tree;
+  std::map<uint64_t, uint64_t> ref;
+  std::mt19937_64 rng(5);
+  int mismatches = 0;
+  for (int i = 0; i < 300000; ++i) {
+    // 前半段以插入为主，后半段以删除为主，覆盖树长高和变矮
+    uint64_t key = rng() % 20000;
+    int op = rng() % 10;
+    bool growing = i < 150000;
+    if (op < (growing ? 6 : 3)) {
+      if (tree.insert(key, i) != ref.emplace(key, i).second) {
+        ++mismatches;
+      }
+    } else if (op < 8) {
+      if (tree.erase(key) != (ref.erase(key) == 1)) {
+        ++mismatches;
+      }
+    } else if (op < 9) {
+      uint64_t k = 0;
+      uint64_t v = 0;
+      bool popped = tree.pop_min(k, v);
+      if (popped != !ref.empty() ||
+          (popped && (k != ref.begin()->first || v != ref.begin()->second))) {
+        ++mismatches;
+      }
+      if (!ref.empty()) {
+        ref.erase(ref.begin());
+      }
+    } else {
+      auto it = tree.find(key);
+      auto expected = ref.find(key);
+      if ((it == tree.end()) != (expected == ref.end()) ||
+          (it != tree.end() && it.value() != expected->second)) {
+        ++mismatches;
+      }
+    }
+  }
+  auto expected = ref.begin();
+  for (auto it = tree.begin(); it != tree.end(); ++it, ++expected) {
+    if (expected == ref.end() || it.key() != expected->first ||
+        it.value() != expected->second) {
+      ++mismatches;
+      break;
+    }
+  }
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t lo = rng() % 20000;
+    uint64_t hi = lo + rng() % 500;
+    uint64_t sum = 0;
+    size_t n = tree.scan(lo, hi, [&sum](uint64_t k, uint64_t) { sum += k; });
+    uint64_t expected_sum = 0;
+    size_t expected_n = 0;
+    for (auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi;
+         ++it) {
+      expected_sum += it->first;
+      ++expected_n;
+    }
+    if (n != expected_n || sum != expected_sum) {
+      ++mismatches;
+    }
+  }
+  std::cout << "random ops: size = " << tree.size() << " (expected "
+            << ref.size() << "), height = " << tree.height()
+            << ", mismatches = " << mismatches << std::endl;
+
+  // 键单调递增时叶子保持全满，之后全部 pop_min 出来应当有序
+  BPlusTree<uint64_t, std::string> events;
+  for (uint64_t t = 0; t < 10000; ++t) {
+    events.insert(t * 3, std::to_string(t));
+  }
+  uint64_t last = 0;
+  uint64_t key = 0;
+  std::string value;
+  bool ordered = true;
+  size_t popped = 0;
+  while (events.pop_min(key, value)) {
+    ordered = ordered && (popped == 0 || key > last) &&
+              value == std::to_string(key / 3);
+    last = key;
+    ++popped;
+  }
+  std::cout << "sequential: popped = " << popped << ", ordered = " << ordered
+            << ", empty = " << events.empty()
+            << ", begin == end: " << (events.begin() == events.end())
+            << std::endl;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string benchmark;
+  std::string map;
+  size_t entries = 0;
+  double ns_per_op = 0;
+};
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         ops;
+}
+
+/**
+ * 让 std::map 和 BPlusTree 用同样的代码测试。
+ */
+struct StdMap {
+  std::map<uint64_t, uint64_t> map;
+
+  bool insert(uint64_t k, uint64_t v) { return map.emplace(k, v).second; }
+
+  bool find(uint64_t k, uint64_t &v) const {
+    auto it = map.find(k);
+    if (it == map.end()) {
+      return false;
+    }
+    v = it->second;
+    return true;
+  }
+
+  bool erase(uint64_t k) { return map.erase(k) == 1; }
+
+  bool pop_min(uint64_t &k, uint64_t &v) {
+    if (map.empty()) {
+      return false;
+    }
+    k = map.begin()->first;
+    v = map.begin()->second;
+    map.erase(map.begin());
+    return true;
+  }
+
+  template <typename F>
+  size_t scan(uint64_t lo, uint64_t hi, F &&f) const {
+    size_t n = 0;
+    for (auto it = map.lower_bound(lo); it != map.end() && it->first < hi;
+         ++it) {
+      f(it->first, it->second);
+      ++n;
+    }
+    return n;
+  }
+};
+
+struct Tree {
+  BPlusTree<uint64_t, uint64_t> tree;
+
+  bool insert(uint64_t k, uint64_t v) { return tree.insert(k, v); }
+
+  bool find(uint64_t k, uint64_t &v) const {
+    auto it = tree.find(k);
+    if (it == tree.end()) {
+      return false;
+    }
+    v = it.value();
+    return true;
+  }
+
+  bool erase(uint64_t k) { return tree.erase(k); }
+
+  bool pop_min(uint64_t &k, uint64_t &v) { return tree.pop_min(k, v); }
+
+  template <typename F>
+  size_t scan(uint64_t lo, uint64_t hi, F &&f) const {
+    return tree.scan(lo, hi, std::forward<F>(f));
+  }
+};
+
+/**
+ * insert：随机插入 n 个键；find：随机查找；scan：从随机位置开始扫 100 个元素，按元素计；
+ * erase：随机删除一半；pop_min：取空剩下的一半；
+ * event_queue：n 个待发事件，每次取出最早的一个，再以随机延迟加入一个（模拟器中的延迟包）。
+ */
+template <typename Map>
+std::vector<Result> BenchMap(const std::string &name,
+                             const std::vector<uint64_t> &keys) {
+  std::vector<Result> results;
+  size_t n = keys.size();
+  auto add = [&](const char *benchmark, double ns) {
+    results.push_back({benchmark, name, n, ns});
+  };
+  uint64_t checksum = 0;
+  std::mt19937_64 rng(n);
+
+  {
+    Map map;
+    auto start = Clock::now();
+    for (uint64_t key : keys) {
+      map.insert(key, key);
+    }
+    add("insert", ns_per_op(start, n));
+
+    std::vector<uint64_t> lookups(keys);
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+    start = Clock::now();
+    for (uint64_t key : lookups) {
+      uint64_t v = 0;
+      map.find(key, v);
+      checksum += v;
+    }
+    add("find", ns_per_op(start, n));
+
+    size_t scans = std::max<size_t>(1, std::min<size_t>(n / 10, 100000));
+    size_t scanned = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < scans; ++i) {
+      // 键在 [0, 2^40) 中均匀分布，100 个元素大约跨 100 * 2^40 / n
+      uint64_t lo = lookups[i];
+      uint64_t hi = lo + 100 * ((uint64_t(1) << 40) / n);
+      scanned += map.scan(lo, hi, [&checksum](uint64_t, uint64_t v) {
+        checksum += v;
+      });
+    }
+    add("scan", ns_per_op(start, std::max<size_t>(scanned, 1)));
+
+    start = Clock::now();
+    for (size_t i = 0; i < n / 2; ++i) {
+      map.erase(lookups[i]);
+    }
+    add("erase", ns_per_op(start, n / 2));
+
+    start = Clock::now();
+    uint64_t k = 0;
+    uint64_t v = 0;
+    size_t popped = 0;
+    while (map.pop_min(k, v)) {
+      checksum += k;
+      ++popped;
+    }
+    add("pop_min", ns_per_op(start, std::max<size_t>(popped, 1)));
+  }
+
+  {
+    // 键的高位是时间，低 20 位是序号，保证唯一
+    Map queue;
+    uint64_t now = 0;
+    uint64_t seq = 0;
+    for (size_t i = 0; i < n; ++i) {
+      queue.insert(((now + rng() % 1000000) << 20) | (seq++ & 0xfffff), 0);
+    }
+    auto start = Clock::now();
+    uint64_t k = 0;
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; ++i) {
+      queue.pop_min(k, v);
+      now = k >> 20;
+      queue.insert(((now + 1 + rng() % 1000000) << 20) | (seq++ & 0xfffff),
+                   v);
+    }
+    add("event_queue", ns_per_op(start, n));
+  }
+
+  if (checksum == 42) {
+    std::cerr << "unlikely checksum" << std::endl;
+  }
+  return results;
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"map\":\"" << r.map
+              << "\",\"entries\":" << r.entries
+              << ",\"ns_per_op\":" << r.ns_per_op << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.map << "," << r.entries << ","
+              << r.ns_per_op << std::endl;
+  }
+}
+
+/**
+ *   ./BPlusTree [--json] [--max-entries=N]
+ * 元素数从 1K 按 10 倍增加到 max-entries（默认 10M），比较 BPlusTree 和 std::map。
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  size_t max_entries = 10000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-entries=", 0) == 0) {
+      max_entries = std::max<size_t>(1000, std::stoull(arg.substr(14)));
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--json] [--max-entries=N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestBPlusTree();
+    std::cout << "benchmark,map,entries,ns_per_op" << std::endl;
+  }
+  std::mt19937_64 rng(2024);
+  for (size_t n = 1000; n <= max_entries; n *= 10) {
+    std::vector<uint64_t> keys(n);
+    for (auto &key : keys) {
+      key = rng() & ((uint64_t(1) << 40) - 1);
+    }
+    for (const auto &r : BenchMap<Tree>("BPlusTree", keys)) {
+      print(r, json);
+    }
+    for (const auto &r : BenchMap<StdMap>("std::map", keys)) {
+      print(r, json);
+    }
+  }
+}
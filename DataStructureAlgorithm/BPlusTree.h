@@ -0,0 +1,475 @@
+#ifndef DATA_STRUCTURE_B_PLUS_TREE_H
+#define DATA_STRUCTURE_B_PLUS_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * 内存中的 B+ 树有序表，节点按约 512 字节设计，一个节点只占几条缓存行。
+ *
+ * 叶子节点的键和值分开存放，查找时只扫键数组；叶子之间用双向链表相连，
+ * 区间扫描和 pop_min 都只顺着叶子走，不需要回到内部节点。
+ * 在最右端追加（键单调递增，例如按发送时间排序的事件）时不做对半分裂，
+ * 而是直接开一个新叶子，叶子保持全满。
+ * 删除时不做节点合并，只回收变空的节点：从一端删除（pop_min）时节点总是满的，
+ * 随机删除较多时节点可能偏空，但查找和扫描结果仍然正确。
+ * 键唯一；K 和 V 需要能默认构造和移动赋值。
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class BPlusTree {
+ private:
+  struct Leaf;
+
+ public:
+  static constexpr int kNodeBytes = 512;
+  static constexpr int kLeafSlots =
+      std::max<int>(8, kNodeBytes / (sizeof(K) + sizeof(V)));
+  static constexpr int kInnerSlots =
+      std::max<int>(8, kNodeBytes / (sizeof(K) + sizeof(void *)));
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using LeafPtr = std::conditional_t<Const, const Leaf *, Leaf *>;
+    using ValueRef = std::conditional_t<Const, const V &, V &>;
+
+    Iterator() = default;
+
+    const K &key() const { return leaf_->keys[pos_]; }
+
+    ValueRef value() const { return leaf_->values[pos_]; }
+
+    Iterator &operator++() {
+      if (++pos_ == leaf_->count) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return leaf_ == other.leaf_ && pos_ == other.pos_;
+    }
+
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    operator Iterator<true>() const { return Iterator<true>(leaf_, pos_); }
+
+   private:
+    friend class BPlusTree;
+    friend class Iterator<!Const>;
+
+    Iterator(LeafPtr leaf, int pos) : leaf_(leaf), pos_(pos) {}
+
+    LeafPtr leaf_ = nullptr;
+    int pos_ = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  BPlusTree() = default;
+
+  explicit BPlusTree(const Compare &comp) : comp_(comp) {}
+
+  ~BPlusTree() { clear(); }
+
+  BPlusTree(const BPlusTree &) = delete;
+  BPlusTree &operator=(const BPlusTree &) = delete;
+
+  BPlusTree(BPlusTree &&other) noexcept { swap(other); }
+
+  BPlusTree &operator=(BPlusTree &&other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  void swap(BPlusTree &other) noexcept {
+    std::swap(root_, other.root_);
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(size_, other.size_);
+    std::swap(height_, other.height_);
+    std::swap(comp_, other.comp_);
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    if (root_ != nullptr) {
+      destroy(root_, height_);
+    }
+    root_ = nullptr;
+    head_ = tail_ = nullptr;
+    size_ = 0;
+    height_ = 0;
+  }
+
+  iterator begin() { return iterator(head_, 0); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(head_, 0); }
+  const_iterator end() const { return const_iterator(); }
+
+  /**
+   * 第一个不小于 key 的元素。
+   */
+  iterator lower_bound(const K &key) {
+    if (root_ == nullptr) {
+      return end();
+    }
+    Leaf *leaf = find_leaf(key);
+    int pos = leaf_lower_bound(leaf, key);
+    if (pos == leaf->count) {
+      return iterator(leaf->next, 0);
+    }
+    return iterator(leaf, pos);
+  }
+
+  const_iterator lower_bound(const K &key) const {
+    return const_cast<BPlusTree *>(this)->lower_bound(key);
+  }
+
+  iterator find(const K &key) {
+    if (root_ == nullptr) {
+      return end();
+    }
+    Leaf *leaf = find_leaf(key);
+    int pos = leaf_lower_bound(leaf, key);
+    if (pos < leaf->count && !comp_(key, leaf->keys[pos])) {
+      return iterator(leaf, pos);
+    }
+    return end();
+  }
+
+  const_iterator find(const K &key) const {
+    return const_cast<BPlusTree *>(this)->find(key);
+  }
+
+  bool contains(const K &key) const { return find(key) != end(); }
+
+  /**
+   * 对 [lo, hi) 中的每个元素按顺序调用 f(key, value)，返回访问的元素个数。
+   */
+  template <typename F>
+  size_t scan(const K &lo, const K &hi, F &&f) const {
+    size_t n = 0;
+    for (const_iterator it = lower_bound(lo);
+         it != end() && comp_(it.key(), hi); ++it) {
+      f(it.key(), it.value());
+      ++n;
+    }
+    return n;
+  }
+
+  /**
+   * 键已存在时不修改，返回 false。
+   */
+  bool insert(const K &key, V value) {
+    return insert_impl(key, std::move(value), false);
+  }
+
+  /**
+   * 键已存在时覆盖旧值，返回是否新插入。
+   */
+  bool insert_or_assign(const K &key, V value) {
+    return insert_impl(key, std::move(value), true);
+  }
+
+  bool erase(const K &key) {
+    if (root_ == nullptr) {
+      return false;
+    }
+    Path path;
+    Leaf *leaf = descend(key, path);
+    int pos = leaf_lower_bound(leaf, key);
+    if (pos == leaf->count || comp_(key, leaf->keys[pos])) {
+      return false;
+    }
+    erase_at(leaf, pos, path);
+    return true;
+  }
+
+  /**
+   * 最小的元素，树为空时未定义。
+   */
+  const K &min_key() const { return head_->keys[0]; }
+
+  /**
+   * 取出最小的元素，树为空时返回 false。
+   */
+  bool pop_min(K &key, V &value) {
+    if (size_ == 0) {
+      return false;
+    }
+    key = std::move(head_->keys[0]);
+    value = std::move(head_->values[0]);
+    if (head_->count > 1) {
+      remove_from_leaf(head_, 0);
+      --size_;
+      return true;
+    }
+    Path path;
+    Node *node = root_;
+    for (int level = height_; level > 0; --level) {
+      path.nodes[path.depth] = static_cast<Inner *>(node);
+      path.index[path.depth++] = 0;
+      node = static_cast<Inner *>(node)->children[0];
+    }
+    erase_at(head_, 0, path);
+    return true;
+  }
+
+  /**
+   * 树的高度，只有一个叶子时为 0，用于观察节点大小的效果。
+   */
+  int height() const { return height_; }
+
+ private:
+  struct Node {
+    int count = 0;
+  };
+
+  struct Leaf : Node {
+    K keys[kLeafSlots];
+    V values[kLeafSlots];
+    Leaf *prev = nullptr;
+    Leaf *next = nullptr;
+  };
+
+  // count 个键，count + 1 个子节点；children[i] 中的键都小于 keys[i]
+  struct Inner : Node {
+    K keys[kInnerSlots];
+    Node *children[kInnerSlots + 1];
+  };
+
+  // 从根到叶子经过的内部节点及所走的子节点下标
+  struct Path {
+    static constexpr int kMaxDepth = 48;
+    Inner *nodes[kMaxDepth];
+    int index[kMaxDepth];
+    int depth = 0;
+  };
+
+  int leaf_lower_bound(const Leaf *leaf, const K &key) const {
+    return static_cast<int>(
+        std::lower_bound(leaf->keys, leaf->keys + leaf->count, key, comp_) -
+        leaf->keys);
+  }
+
+  int child_index(const Inner *inner, const K &key) const {
+    return static_cast<int>(
+        std::upper_bound(inner->keys, inner->keys + inner->count, key, comp_) -
+        inner->keys);
+  }
+
+  Leaf *find_leaf(const K &key) const {
+    Node *node = root_;
+    for (int level = height_; level > 0; --level) {
+      Inner *inner = static_cast<Inner *>(node);
+      node = inner->children[child_index(inner, key)];
+    }
+    return static_cast<Leaf *>(node);
+  }
+
+  Leaf *descend(const K &key, Path &path) const {
+    Node *node = root_;
+    for (int level = height_; level > 0; --level) {
+      Inner *inner = static_cast<Inner *>(node);
+      int i = child_index(inner, key);
+      path.nodes[path.depth] = inner;
+      path.index[path.depth++] = i;
+      node = inner->children[i];
+    }
+    return static_cast<Leaf *>(node);
+  }
+
+  bool insert_impl(const K &key, V &&value, bool assign) {
+    if (root_ == nullptr) {
+      Leaf *leaf = new Leaf();
+      root_ = head_ = tail_ = leaf;
+    }
+    Path path;
+    Leaf *leaf = descend(key, path);
+    int pos = leaf_lower_bound(leaf, key);
+    if (pos < leaf->count && !comp_(key, leaf->keys[pos])) {
+      if (assign) {
+        leaf->values[pos] = std::move(value);
+      }
+      return false;
+    }
+    ++size_;
+    if (leaf->count < kLeafSlots) {
+      insert_into_leaf(leaf, pos, key, std::move(value));
+      return true;
+    }
+
+    // 最右端追加时新叶子只放新元素，否则对半分
+    Leaf *right = new Leaf();
+    int keep = (leaf == tail_ && pos == leaf->count) ? leaf->count
+                                                     : leaf->count / 2;
+    std::move(leaf->keys + keep, leaf->keys + leaf->count, right->keys);
+    std::move(leaf->values + keep, leaf->values + leaf->count, right->values);
+    right->count = leaf->count - keep;
+    leaf->count = keep;
+    right->next = leaf->next;
+    right->prev = leaf;
+    if (leaf->next != nullptr) {
+      leaf->next->prev = right;
+    } else {
+      tail_ = right;
+    }
+    leaf->next = right;
+    if (pos <= keep && keep < kLeafSlots) {
+      insert_into_leaf(leaf, pos, key, std::move(value));
+    } else {
+      insert_into_leaf(right, pos - keep, key, std::move(value));
+    }
+    insert_into_parent(path, right->keys[0], right);
+    return true;
+  }
+
+  void insert_into_leaf(Leaf *leaf, int pos, const K &key, V &&value) {
+    std::move_backward(leaf->keys + pos, leaf->keys + leaf->count,
+                       leaf->keys + leaf->count + 1);
+    std::move_backward(leaf->values + pos, leaf->values + leaf->count,
+                       leaf->values + leaf->count + 1);
+    leaf->keys[pos] = key;
+    leaf->values[pos] = std::move(value);
+    ++leaf->count;
+  }
+
+  /**
+   * 子节点分裂后把 (separator, right) 插到父节点中 right 左兄弟的右边，父节点满了继续分裂。
+   */
+  void insert_into_parent(Path &path, K separator, Node *right) {
+    while (path.depth > 0) {
+      Inner *inner = path.nodes[--path.depth];
+      int pos = path.index[path.depth];
+      if (inner->count < kInnerSlots) {
+        insert_into_inner(inner, pos, separator, right);
+        return;
+      }
+      // 中间的键上移，左边保留 mid 个键
+      int mid = inner->count / 2;
+      Inner *sibling = new Inner();
+      K promoted = std::move(inner->keys[mid]);
+      std::move(inner->keys + mid + 1, inner->keys + inner->count,
+                sibling->keys);
+      std::copy(inner->children + mid + 1, inner->children + inner->count + 1,
+                sibling->children);
+      sibling->count = inner->count - mid - 1;
+      inner->count = mid;
+      if (pos <= mid) {
+        insert_into_inner(inner, pos, separator, right);
+      } else {
+        insert_into_inner(sibling, pos - mid - 1, separator, right);
+      }
+      separator = std::move(promoted);
+      right = sibling;
+    }
+    Inner *root = new Inner();
+    root->keys[0] = std::move(separator);
+    root->children[0] = root_;
+    root->children[1] = right;
+    root->count = 1;
+    root_ = root;
+    ++height_;
+  }
+
+  /**
+   * 在 children[pos] 之后插入子节点 child，分隔键放在 keys[pos]。
+   */
+  void insert_into_inner(Inner *inner, int pos, K &separator, Node *child) {
+    std::move_backward(inner->keys + pos, inner->keys + inner->count,
+                       inner->keys + inner->count + 1);
+    std::copy_backward(inner->children + pos + 1,
+                       inner->children + inner->count + 1,
+                       inner->children + inner->count + 2);
+    inner->keys[pos] = std::move(separator);
+    inner->children[pos + 1] = child;
+    ++inner->count;
+  }
+
+  void remove_from_leaf(Leaf *leaf, int pos) {
+    std::move(leaf->keys + pos + 1, leaf->keys + leaf->count,
+              leaf->keys + pos);
+    std::move(leaf->values + pos + 1, leaf->values + leaf->count,
+              leaf->values + pos);
+    --leaf->count;
+  }
+
+  /**
+   * 删除叶子中的第 pos 个元素，叶子变空时连同变空的祖先一起回收。
+   */
+  void erase_at(Leaf *leaf, int pos, Path &path) {
+    remove_from_leaf(leaf, pos);
+    --size_;
+    if (leaf->count > 0) {
+      return;
+    }
+    (leaf->prev != nullptr ? leaf->prev->next : head_) = leaf->next;
+    (leaf->next != nullptr ? leaf->next->prev : tail_) = leaf->prev;
+    delete leaf;
+
+    while (path.depth > 0) {
+      Inner *inner = path.nodes[--path.depth];
+      int i = path.index[path.depth];
+      if (inner->count == 0) {
+        // 唯一的子节点也没了，继续向上删除
+        delete inner;
+        continue;
+      }
+      // 去掉 children[i] 以及它一侧的分隔键
+      int key_pos = i > 0 ? i - 1 : 0;
+      std::move(inner->keys + key_pos + 1, inner->keys + inner->count,
+                inner->keys + key_pos);
+      std::copy(inner->children + i + 1, inner->children + inner->count + 1,
+                inner->children + i);
+      --inner->count;
+      break;
+    }
+    if (size_ == 0) {
+      // 空叶子总会被回收，所以树为空时从根到这个叶子的节点都已删除
+      root_ = nullptr;
+      head_ = tail_ = nullptr;
+      height_ = 0;
+      return;
+    }
+    // 根只剩一个子节点时降低树高
+    while (height_ > 0 && root_->count == 0) {
+      Inner *old = static_cast<Inner *>(root_);
+      root_ = old->children[0];
+      delete old;
+      --height_;
+    }
+  }
+
+  void destroy(Node *node, int level) {
+    if (level == 0) {
+      delete static_cast<Leaf *>(node);
+      return;
+    }
+    Inner *inner = static_cast<Inner *>(node);
+    for (int i = 0; i <= inner->count; ++i) {
+      destroy(inner->children[i], level - 1);
+    }
+    delete inner;
+  }
+
+  Node *root_ = nullptr;
+  Leaf *head_ = nullptr;
+  Leaf *tail_ = nullptr;
+  size_t size_ = 0;
+  int height_ = 0;
+  Compare comp_;
+};
+
+#endif /* DATA_STRUCTURE_B_PLUS_TREE_H */
@@ -1,73 +1,10 @@
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
-/**
- * 长度固定的循环队列，底层使用vector实现。
- */
-template <typename T>
-class CircleQueue {
- public:
-  CircleQueue(int capacity) : capacity_(capacity), size_(0) {
-    if (capacity < 0) {
-      throw std::length_error(
-          "cannot create a circular queue with a capacity less than 0");
-      // std::abort();
-    }
-    data_.resize(capacity_ + 1);
-    head_ = tail_ = 0;
-  }
-
-  ~CircleQueue() = default;
-
-  /**
-   * FIXME: T&&
-   */
-  bool push(T value) {
-    if (full()) {
-      return false;
-    }
-    data_[tail_] = value;
-    tail_ = (tail_ + 1) % data_.size();
-    ++size_;
-    return true;
-  }
-
-  bool pop() {
-    if (empty()) {
-      return false;
-    }
-    head_ = (head_ + 1) % data_.size();
-    --size_;
-    return true;
-  }
-
-  T front() {
-    if (empty()) {
-    }
-    return data_[head_];
-  }
-
-  T rear() {
-    if (empty()) {
-    }
-    return data_[(tail_ - 1) % data_.size()];
-  }
-
-  bool empty() { return tail_ == head_; }
-
-  bool full() { return ((tail_ + 1) % data_.size()) == head_; }
-
-  int capacity() const { return capacity_; }
-
-  int size() const { return size_; }
-
- private:
-  int capacity_;
-  int size_;
-  std::vector<T> data_;
-  int head_;
-  int tail_;
-};
+#include "CircleQueue.h"
 
 void TestCircleQueue() {
   CircleQueue<int> que(10);
@@ -92,4 +29,244 @@ void TestCircleQueue() {
   std::cout << "que.size() = " << que.size() << std::endl;
 }
 
-int main() { TestCircleQueue(); }
\ No newline at end of file
+void TestCircleQueueBatch() {
+  CircleQueue<int> que(8);
+  int input[] = {1, 2, 3, 4, 5, 6};
+  que.push_n(input, 6);
+  int output[4];
+  std::cout << "pop_n: " << que.pop_n(output, 4) << std::endl;
+  // 写入会绕回数组开头，数据分成两段
+  std::cout << "push_n: " << que.push_n(input, 6) << std::endl;
+  auto spans = que.peek_spans();
+  std::cout << "spans: " << spans.first.size() << " + " << spans.second.size()
+            << " :";
+  for (int x : spans.first) {
+    std::cout << " " << x;
+  }
+  for (int x : spans.second) {
+    std::cout << " " << x;
+  }
+  std::cout << std::endl;
+  que.consume(spans.first.size() + spans.second.size());
+  std::cout << "que.size() = " << que.size() << std::endl;
+
+  CircleQueue<std::string> strings(2);
+  strings.emplace(3, 'x');
+  strings.push("rear");
+  std::cout << "emplace: " << strings.front() << " " << strings.rear()
+            << ", full: " << strings.emplace("no room") << std::endl;
+}
+
+void TestCircleQueueOverwrite() {
+  // 只保留最近 4 个采样
+  CircleQueue<int> history(4, OverflowPolicy::kOverwrite);
+  for (int i = 1; i <= 10; ++i) {
+    history.push(i);
+  }
+  int input[] = {11, 12, 13, 14, 15, 16};
+  std::cout << "push_n: " << history.push_n(input, 3) << ", history:";
+  auto spans = history.peek_spans();
+  for (int x : spans.first) {
+    std::cout << " " << x;
+  }
+  for (int x : spans.second) {
+    std::cout << " " << x;
+  }
+  std::cout << std::endl;
+  // 超过容量时只保留最后 4 个，返回值也是 4
+  size_t kept = history.push_n(input, 6);
+  std::cout << "push_n(6): " << kept << ", front = " << history.front()
+            << ", rear = " << history.rear() << ", size = " << history.size()
+            << std::endl;
+}
+
+/**
+ * 没有默认构造函数、统计构造和析构次数的元素类型。
+ */
+struct Sample {
+  static int alive;
+  explicit Sample(int v) : value(std::to_string(v)) { ++alive; }
+  Sample(const Sample &other) : value(other.value) { ++alive; }
+  Sample(Sample &&other) noexcept : value(std::move(other.value)) { ++alive; }
+  Sample &operator=(const Sample &) = default;
+  Sample &operator=(Sample &&) = default;
+  ~Sample() { --alive; }
+  std::string value;
+};
+
+int Sample::alive = 0;
+
+void TestCircleQueueStorage() {
+  {
+    CircleQueue<Sample> que(1000, OverflowPolicy::kOverwrite);
+    std::cout << "alive after construct: " << Sample::alive << std::endl;
+    for (int i = 0; i < 1500; ++i) {
+      que.emplace(i);
+    }
+    std::cout << "alive after 1500 emplace: " << Sample::alive
+              << ", front = " << que.front().value << std::endl;
+    CircleQueue<Sample> copy = que;
+    que.consume(600);
+    std::cout << "alive after copy + consume: " << Sample::alive << std::endl;
+    que = std::move(copy);
+    std::cout << "alive after move: " << Sample::alive << std::endl;
+  }
+  std::cout << "alive after destruct: " << Sample::alive << std::endl;
+
+  // 容量固定为 8，存储空间在对象内部
+  CircleQueue<double, 8> fixed;
+  for (int i = 0; i < 10; ++i) {
+    fixed.push(i * 0.5);
+  }
+  std::cout << "fixed: sizeof = " << sizeof(fixed)
+            << ", size = " << fixed.size() << ", rear = " << fixed.rear()
+            << std::endl;
+  CircleQueue<Sample, 4> samples(OverflowPolicy::kOverwrite);
+  for (int i = 0; i < 6; ++i) {
+    samples.emplace(i);
+  }
+  CircleQueue<Sample, 4> moved = std::move(samples);
+  std::cout << "fixed overwrite: front = " << moved.front().value
+            << ", alive = " << Sample::alive << std::endl;
+}
+
+/**
+ * 拷贝构造在 copies_left 减到 0 时抛出异常（为负数时不抛出）。
+ */
+struct Fragile {
+  static int alive;
+  static int copies_left;
+  explicit Fragile(int v) : value(v) { ++alive; }
+  Fragile(const Fragile &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    ++alive;
+  }
+  ~Fragile() { --alive; }
+  int value;
+};
+
+int Fragile::alive = 0;
+int Fragile::copies_left = -1;
+
+/**
+ * 覆盖模式下用队首元素 push、构造抛出异常，以及被移动后的队列。
+ */
+void TestCircleQueueEdgeCases() {
+  CircleQueue<Sample> ring(3, OverflowPolicy::kOverwrite);
+  for (int i = 0; i < 3; ++i) {
+    ring.emplace(i);
+  }
+  // 队列已满，被覆盖的正是参数引用的元素
+  ring.push(ring.front());
+  std::cout << "push(front()) when full: front = " << ring.front().value
+            << ", rear = " << ring.rear().value << std::endl;
+
+  struct Strict {
+    explicit Strict(int v) : value(v) {
+      if (v < 0) {
+        throw std::invalid_argument("negative");
+      }
+    }
+    int value;
+  };
+  CircleQueue<Strict> strict(2, OverflowPolicy::kOverwrite);
+  strict.emplace(1);
+  strict.emplace(2);
+  try {
+    strict.emplace(-1);
+  } catch (const std::invalid_argument &) {
+  }
+  std::cout << "throwing emplace when full: size = " << strict.size()
+            << ", front = " << strict.front().value << std::endl;
+
+  // 批量拷贝中途抛出：写空闲槽位时抛出队列不变，覆盖时抛出只丢掉最旧的元素
+  {
+    std::vector<Fragile> batch;
+    for (int i = 10; i < 14; ++i) {
+      batch.emplace_back(i);
+    }
+    CircleQueue<Fragile> fragile(4, OverflowPolicy::kOverwrite);
+    fragile.emplace(1);
+    fragile.emplace(2);
+    fragile.consume(1);
+    fragile.emplace(3);
+    // 队列里是 2 3，尾部跨过缓冲区末尾，空闲的两个槽位在回绕的两侧
+    Fragile::copies_left = 1;
+    try {
+      fragile.push_n(batch.data(), 2);
+    } catch (const std::runtime_error &) {
+    }
+    std::cout << "throwing push_n into free slots: size = " << fragile.size()
+              << ", alive = " << Fragile::alive - 4;
+    Fragile::copies_left = 3;
+    try {
+      fragile.push_n(batch.data(), 4);
+    } catch (const std::runtime_error &) {
+    }
+    std::cout << ", while overwriting: size = " << fragile.size()
+              << ", alive = " << Fragile::alive - 4 << std::endl;
+    Fragile::copies_left = -1;
+  }
+  std::cout << "fragile alive after destruct: " << Fragile::alive << std::endl;
+
+  CircleQueue<Sample> source(4);
+  source.emplace(7);
+  CircleQueue<Sample> target(std::move(source));
+  int moved_capacity = source.capacity();
+  bool pushed = source.push(Sample(8));
+  source = target;
+  std::cout << "moved-from: capacity = " << moved_capacity
+            << ", push = " << pushed
+            << ", size after copy-assign = " << source.size()
+            << ", front = " << source.front().value << std::endl;
+}
+
+/**
+ * 以 10ms 音频帧（480 个 float）为单位写入、读出，比较逐个元素和批量操作的耗时。
+ */
+void BenchmarkCircleQueueBatch() {
+  const int kFrame = 480;
+  const int kFrames = 20000;
+  CircleQueue<float> que(4 * kFrame);
+  std::vector<float> frame(kFrame, 1.0f);
+  std::vector<float> out(kFrame);
+
+  auto start = std::chrono::steady_clock::now();
+  double sum = 0;
+  for (int f = 0; f < kFrames; ++f) {
+    for (float x : frame) {
+      que.push(x);
+    }
+    for (int i = 0; i < kFrame; ++i) {
+      sum += que.front();
+      que.pop();
+    }
+  }
+  auto single = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int f = 0; f < kFrames; ++f) {
+    que.push_n(frame.data(), kFrame);
+    que.pop_n(out.data(), kFrame);
+    sum += out[0];
+  }
+  auto batch = std::chrono::steady_clock::now() - start;
+
+  using std::chrono::microseconds;
+  std::cout << "per element: "
+            << std::chrono::duration_cast<microseconds>(single).count()
+            << "us, push_n/pop_n: "
+            << std::chrono::duration_cast<microseconds>(batch).count() << "us"
+            << " (checksum " << sum << ")" << std::endl;
+}
+
+int main() {
+  TestCircleQueue();
+  TestCircleQueueBatch();
+  TestCircleQueueOverwrite();
+  TestCircleQueueStorage();
+  TestCircleQueueEdgeCases();
+  BenchmarkCircleQueueBatch();
+}
\ No newline at end of file
@@ -0,0 +1,375 @@
+#ifndef DATA_STRUCTURE_CIRCLE_QUEUE_H
+#define DATA_STRUCTURE_CIRCLE_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+/**
+ * 队列满时 push 的行为。
+ */
+enum class OverflowPolicy {
+  kReject,     // push 返回 false
+  kOverwrite,  // 覆盖最旧的元素
+};
+
+/**
+ * 长度固定的循环队列。
+ *
+ * 存储空间不做初始化，元素在 push 时才构造、pop 时析构，
+ * 因此 T 不需要默认构造函数，创建大容量的队列也没有额外开销。
+ *  - CircleQueue<T>：容量在运行时指定，存储空间在堆上；
+ *  - CircleQueue<T, N>：容量为编译期常量 N，存储空间是对象内部的 std::array，
+ *    可以放在栈上或直接嵌入其他结构体。
+ */
+template <typename T, size_t N = 0>
+class CircleQueue {
+ public:
+#if defined(__cpp_lib_span)
+  using Span = std::span<T>;
+#else
+  /**
+   * C++20 之前 std::span 的替代品，只提供遍历需要的接口。
+   */
+  class Span {
+   public:
+    Span() = default;
+    Span(T *data, size_t size) : data_(data), size_(size) {}
+    T *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T *begin() const { return data_; }
+    T *end() const { return data_ + size_; }
+    T &operator[](size_t i) const { return data_[i]; }
+
+   private:
+    T *data_ = nullptr;
+    size_t size_ = 0;
+  };
+#endif
+
+  CircleQueue(int capacity, OverflowPolicy policy = OverflowPolicy::kReject)
+      : capacity_(capacity), policy_(policy) {
+    static_assert(N == 0, "fixed-capacity CircleQueue takes no capacity");
+    if (capacity < 0) {
+      throw std::length_error(
+          "cannot create a circular queue with a capacity less than 0");
+      // std::abort();
+    }
+    slots_.reset(new Slot[capacity_]);
+  }
+
+  explicit CircleQueue(OverflowPolicy policy = OverflowPolicy::kReject)
+      : capacity_(static_cast<int>(N)), policy_(policy) {
+    static_assert(N > 0, "CircleQueue<T> needs a capacity");
+  }
+
+  CircleQueue(const CircleQueue &other)
+      : capacity_(other.capacity_), policy_(other.policy_) {
+    if constexpr (N == 0) {
+      slots_.reset(new Slot[capacity_]);
+    }
+    other.for_each([this](const T &value) { emplace(value); });
+  }
+
+  CircleQueue(CircleQueue &&other) noexcept(N == 0 ||
+                                            std::is_nothrow_move_constructible<T>::value)
+      : capacity_(other.capacity_), policy_(other.policy_) {
+    if constexpr (N == 0) {
+      steal(other);
+    } else {
+      other.for_each([this](T &value) { emplace(std::move(value)); });
+      other.clear();
+    }
+  }
+
+  CircleQueue &operator=(const CircleQueue &other) {
+    if (this != &other) {
+      clear();
+      if constexpr (N == 0) {
+        if (capacity_ != other.capacity_) {
+          slots_.reset(new Slot[other.capacity_]);
+          capacity_ = other.capacity_;
+        }
+      }
+      policy_ = other.policy_;
+      other.for_each([this](const T &value) { emplace(value); });
+    }
+    return *this;
+  }
+
+  CircleQueue &operator=(CircleQueue &&other) noexcept(
+      N == 0 || std::is_nothrow_move_constructible<T>::value) {
+    if (this != &other) {
+      clear();
+      policy_ = other.policy_;
+      if constexpr (N == 0) {
+        capacity_ = other.capacity_;
+        steal(other);
+      } else {
+        other.for_each([this](T &value) { emplace(std::move(value)); });
+        other.clear();
+      }
+    }
+    return *this;
+  }
+
+  ~CircleQueue() { clear(); }
+
+  bool push(const T &value) { return emplace(value); }
+
+  bool push(T &&value) { return emplace(std::move(value)); }
+
+  /**
+   * 在队尾原地构造元素。队列满时，kReject 返回 false 且不使用参数，
+   * kOverwrite 先丢弃最旧的元素。
+   */
+  template <typename... Args>
+  bool emplace(Args &&...args) {
+    if (full()) {
+      if (policy_ == OverflowPolicy::kReject || capacity_ == 0) {
+        return false;
+      }
+      // 参数可能引用最旧的元素（例如 q.push(q.front())），构造也可能抛出异常，
+      // 所以先在临时对象中构造好新元素，再丢弃最旧的元素
+      T value(std::forward<Args>(args)...);
+      pop();
+      new (slot(wrap(head_ + size_))) T(std::move(value));
+      ++size_;
+      return true;
+    }
+    new (slot(wrap(head_ + size_))) T(std::forward<Args>(args)...);
+    ++size_;
+    return true;
+  }
+
+  bool pop() {
+    if (empty()) {
+      return false;
+    }
+    slot(head_)->~T();
+    head_ = wrap(head_ + 1);
+    --size_;
+    return true;
+  }
+
+  void clear() {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      for_each([](T &value) { value.~T(); });
+    }
+    head_ = size_ = 0;
+  }
+
+  /**
+   * 把 [data, data + n) 追加到队尾，返回实际追加的个数。
+   * kReject 时只追加放得下的部分；kOverwrite 时丢弃最旧的元素腾出空间，
+   * n 超过容量时只保留最后 capacity() 个，返回 capacity()。
+   * 最多两次连续拷贝，T 可平凡拷贝时使用 memcpy。
+   *
+   * 拷贝抛出异常时已构造的新元素都会析构，队列仍然有效。先写空闲槽位，
+   * 这部分抛出时队列不变；需要覆盖旧元素时它们在拷贝前就被丢弃，此时只保证基本异常安全。
+   */
+  size_t push_n(const T *data, size_t n) {
+    size_t room = static_cast<size_t>(capacity_ - size_);
+    if (n > room) {
+      if (policy_ == OverflowPolicy::kReject) {
+        n = room;
+      } else if (n > static_cast<size_t>(capacity_)) {
+        data += n - capacity_;
+        n = capacity_;
+      }
+    }
+    size_t tail = wrap(head_ + size_);
+    size_t fresh = std::min(n, room);
+    copy_wrapped(data, fresh, tail);
+    if (n > fresh) {
+      // 新元素接在 tail 之后，正好落在最旧的 n - fresh 个元素上
+      consume(n - fresh);
+      try {
+        copy_wrapped(data + fresh, n - fresh, wrap(tail + fresh));
+      } catch (...) {
+        destroy_wrapped(fresh, tail);
+        throw;
+      }
+    }
+    size_ += static_cast<int>(n);
+    return n;
+  }
+
+  /**
+   * 从队首取出最多 n 个元素写入 out，返回取出的个数。
+   */
+  size_t pop_n(T *out, size_t n) {
+    auto spans = peek_spans();
+    n = std::min(n, static_cast<size_t>(size_));
+    size_t first = std::min(n, spans.first.size());
+    move_run(spans.first.data(), first, out);
+    move_run(spans.second.data(), n - first, out + first);
+    consume(n);
+    return n;
+  }
+
+  /**
+   * 返回队列中全部元素的视图，按先后顺序分为最多两段（第二段可能为空），不拷贝。
+   * 视图在下一次修改队列之前有效，读完后用 consume 丢弃。
+   */
+  std::pair<Span, Span> peek_spans() {
+    size_t first = std::min(static_cast<size_t>(size_),
+                            static_cast<size_t>(capacity_ - head_));
+    return {Span(base() + head_, first), Span(base(), size_ - first)};
+  }
+
+  /**
+   * 丢弃队首的 n 个元素（不超过 size()）。
+   */
+  void consume(size_t n) {
+    n = std::min(n, static_cast<size_t>(size_));
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      for (size_t i = 0; i < n; ++i) {
+        slot(wrap(head_ + i))->~T();
+      }
+    }
+    head_ = wrap(head_ + n);
+    size_ -= static_cast<int>(n);
+  }
+
+  T &front() {
+    if (empty()) {
+      throw std::out_of_range("front() on empty CircleQueue");
+    }
+    return *slot(head_);
+  }
+
+  T &rear() {
+    if (empty()) {
+      throw std::out_of_range("rear() on empty CircleQueue");
+    }
+    return *slot(wrap(head_ + size_ - 1));
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  bool full() const { return size_ == capacity_; }
+
+  int capacity() const { return capacity_; }
+
+  int size() const { return size_; }
+
+  OverflowPolicy policy() const { return policy_; }
+
+ private:
+  struct Slot {
+    alignas(T) unsigned char bytes[sizeof(T)];
+  };
+
+  // Slot 与 T 的大小和对齐相同，Slot 数组可以当作 T 数组访问。
+  // 被移动后的堆存储队列没有缓冲区，此时返回空指针，容量为 0 时不会被解引用
+  T *base() { return std::launder(reinterpret_cast<T *>(slot_data())); }
+
+  const T *base() const {
+    return std::launder(reinterpret_cast<const T *>(slot_data()));
+  }
+
+  Slot *slot_data() const {
+    if constexpr (N == 0) {
+      return slots_.get();
+    } else {
+      return const_cast<Slot *>(slots_.data());
+    }
+  }
+
+  T *slot(size_t index) { return base() + index; }
+
+  // index 不超过 2 * capacity_ - 1
+  size_t wrap(size_t index) const {
+    return index >= static_cast<size_t>(capacity_) ? index - capacity_ : index;
+  }
+
+  template <typename F>
+  void for_each(F &&f) const {
+    for (int i = 0; i < size_; ++i) {
+      f(base()[wrap(head_ + i)]);
+    }
+  }
+
+  template <typename F>
+  void for_each(F &&f) {
+    for (int i = 0; i < size_; ++i) {
+      f(*slot(wrap(head_ + i)));
+    }
+  }
+
+  // 不分配内存：other 留下空的缓冲区和 0 容量，之后仍可以析构、赋值
+  void steal(CircleQueue &other) noexcept {
+    slots_ = std::move(other.slots_);
+    head_ = other.head_;
+    size_ = other.size_;
+    other.capacity_ = 0;
+    other.head_ = other.size_ = 0;
+  }
+
+  // 目标是未初始化的存储
+  static void copy_run(const T *src, size_t n, T *dst) {
+    if (n == 0) {
+      return;
+    }
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      std::memcpy(dst, src, n * sizeof(T));
+    } else {
+      std::uninitialized_copy(src, src + n, dst);
+    }
+  }
+
+  // 从下标 pos 开始构造 n 个元素，越过缓冲区末尾时回到开头；抛出时不留下已构造的元素
+  void copy_wrapped(const T *src, size_t n, size_t pos) {
+    size_t first = std::min(n, static_cast<size_t>(capacity_) - pos);
+    copy_run(src, first, base() + pos);
+    try {
+      copy_run(src + first, n - first, base());
+    } catch (...) {
+      destroy_wrapped(first, pos);
+      throw;
+    }
+  }
+
+  void destroy_wrapped(size_t n, size_t pos) noexcept {
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      for (size_t i = 0; i < n; ++i) {
+        slot(wrap(pos + i))->~T();
+      }
+    }
+  }
+
+  // 目标是已构造的对象，源对象之后由 consume 析构
+  static void move_run(T *src, size_t n, T *dst) {
+    if (n == 0) {
+      return;
+    }
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      std::memcpy(dst, src, n * sizeof(T));
+    } else {
+      std::move(src, src + n, dst);
+    }
+  }
+
+  using Storage = std::conditional_t<N == 0, std::unique_ptr<Slot[]>,
+                                     std::array<Slot, (N == 0 ? 1 : N)>>;
+
+  Storage slots_;
+  int capacity_;
+  int head_ = 0;
+  int size_ = 0;
+  OverflowPolicy policy_;
+};
+
+#endif /* DATA_STRUCTURE_CIRCLE_QUEUE_H */
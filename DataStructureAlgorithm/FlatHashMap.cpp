@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+/**
+ * 随机插入、删除、查找，每一步都与 std::unordered_map 的结果比较。
+ */
+void TestFlatHashMap() {
+  FlatHashMap<std::string, int> map;
+  map["one"] = 1;
+  map.emplace("two", 2);
+  map.try_emplace("three", 3);
+  map.insert_or_assign("one", 11);
+  std::cout << "size = " << map.size() << ", one = " << map.at("one")
+            << ", contains(four) = " << map.contains("four") << std::endl;
+
+  std::mt19937_64 rng(42);
+  FlatHashMap<uint64_t, uint64_t> flat;
+  std::unordered_map<uint64_t, uint64_t> ref;
+  int mismatches = 0;
+  for (int i = 0; i < 200000; ++i) {
+    // 键的范围较小，插入、删除会反复命中同一批键，产生大量墓碑
+    uint64_t key = rng() % 5000;
+    switch (rng() % 3) {
+      case 0:
+        if (flat.insert({key, i}).second != ref.insert({key, i}).second) {
+          ++mismatches;
+        }
+        break;
+      case 1:
+        if (flat.erase(key) != ref.erase(key)) {
+          ++mismatches;
+        }
+        break;
+      default: {
+        auto it = flat.find(key);
+        auto expected = ref.find(key);
+        if ((it == flat.end()) != (expected == ref.end()) ||
+            (it != flat.end() && it->second != expected->second)) {
+          ++mismatches;
+        }
+      }
+    }
+  }
+  size_t iterated = 0;
+  for (const auto &kv : flat) {
+    if (ref.at(kv.first) != kv.second) {
+      ++mismatches;
+    }
+    ++iterated;
+  }
+  std::cout << "random ops: size = " << flat.size() << " (expected "
+            << ref.size() << "), iterated = " << iterated
+            << ", capacity = " << flat.capacity()
+            << ", mismatches = " << mismatches << std::endl;
+
+  // 与 NetworkSimulator 中一样，遍历时按条件删除
+  for (auto it = flat.begin(); it != flat.end();) {
+    if (it->first % 2 == 0) {
+      it = flat.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  size_t odd = std::count_if(ref.begin(), ref.end(),
+                             [](const auto &kv) { return kv.first % 2 == 1; });
+  FlatHashMap<uint64_t, uint64_t> copy = flat;
+  FlatHashMap<uint64_t, uint64_t> moved = std::move(copy);
+  std::cout << "erase while iterating: size = " << moved.size()
+            << " (expected " << odd << ")" << std::endl;
+}
+
+/**
+ * 值的构造函数抛异常时，表里不能留下半构造的槽位，size 也不能变。
+ */
+struct Counted {
+  static int live;
+  static int throw_after;
+
+  explicit Counted(int v) : value(v) {
+    if (throw_after >= 0 && throw_after-- == 0) {
+      throw std::runtime_error("Counted");
+    }
+    ++live;
+  }
+  Counted(const Counted &other) : Counted(other.value) {}
+  ~Counted() { --live; }
+
+  int value;
+};
+
+int Counted::live = 0;
+int Counted::throw_after = -1;
+
+void TestFlatHashMapExceptions() {
+  int failures = 0;
+  {
+    FlatHashMap<int, Counted> map;
+    for (int i = 0; i < 100; ++i) {
+      Counted::throw_after = i % 7 == 0 ? 0 : -1;
+      try {
+        map.try_emplace(i, i);
+      } catch (const std::runtime_error &) {
+      }
+    }
+    Counted::throw_after = -1;
+    size_t iterated = 0;
+    for (const auto &kv : map) {
+      failures += kv.first % 7 == 0 || kv.second.value != kv.first;
+      ++iterated;
+    }
+    failures += map.size() != 85 || iterated != 85 ||
+                Counted::live != 85;
+    // 拷贝到一半抛出，已拷贝的元素也要析构
+    Counted::throw_after = 40;
+    try {
+      FlatHashMap<int, Counted> copy = map;
+      ++failures;
+    } catch (const std::runtime_error &) {
+    }
+    Counted::throw_after = -1;
+    failures += Counted::live != 85;
+  }
+  failures += Counted::live != 0;
+  std::cout << "throwing constructor: live = " << Counted::live
+            << ", failures = " << failures << std::endl;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string benchmark;
+  std::string map;
+  size_t keys = 0;
+  double ns_per_op = 0;
+};
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         ops;
+}
+
+/**
+ * insert：从空表逐个插入（不预留空间）；find_hit / find_miss：随机顺序查找存在 / 不存在的键；
+ * iterate：遍历求和，按元素计；erase：随机删除一半的键。
+ */
+template <class Map>
+std::vector<Result> BenchMap(const std::string &name,
+                             const std::vector<uint64_t> &keys,
+                             const std::vector<uint64_t> &lookups,
+                             const std::vector<uint64_t> &misses) {
+  std::vector<Result> results;
+  auto add = [&](const char *benchmark, double ns) {
+    results.push_back({benchmark, name, keys.size(), ns});
+  };
+  uint64_t checksum = 0;
+
+  Map map;
+  auto start = Clock::now();
+  for (uint64_t key : keys) {
+    map[key] = key;
+  }
+  add("insert", ns_per_op(start, keys.size()));
+
+  start = Clock::now();
+  for (uint64_t key : lookups) {
+    checksum += map.find(key)->second;
+  }
+  add("find_hit", ns_per_op(start, lookups.size()));
+
+  start = Clock::now();
+  for (uint64_t key : misses) {
+    checksum += map.find(key) == map.end();
+  }
+  add("find_miss", ns_per_op(start, misses.size()));
+
+  start = Clock::now();
+  for (const auto &kv : map) {
+    checksum += kv.second;
+  }
+  add("iterate", ns_per_op(start, map.size()));
+
+  start = Clock::now();
+  for (size_t i = 0; i < lookups.size() / 2; ++i) {
+    checksum += map.erase(lookups[i]);
+  }
+  add("erase", ns_per_op(start, lookups.size() / 2));
+
+  if (checksum == 42) {
+    std::cerr << "unlikely checksum" << std::endl;
+  }
+  return results;
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"map\":\"" << r.map
+              << "\",\"keys\":" << r.keys << ",\"ns_per_op\":" << r.ns_per_op
+              << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.map << "," << r.keys << ","
+              << r.ns_per_op << std::endl;
+  }
+}
+
+/**
+ *   ./FlatHashMap [--json] [--max-keys=N]
+ * 键数从 1K 按 10 倍增加到 max-keys（默认 10M），每个规模比较 FlatHashMap 和 std::unordered_map。
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  size_t max_keys = 10000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-keys=", 0) == 0) {
+      max_keys = std::max<size_t>(1000, std::stoull(arg.substr(11)));
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--json] [--max-keys=N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestFlatHashMap();
+    TestFlatHashMapExceptions();
+    std::cout << "benchmark,map,keys,ns_per_op" << std::endl;
+  }
+  std::mt19937_64 rng(2024);
+  for (size_t n = 1000; n <= max_keys; n *= 10) {
+    std::vector<uint64_t> keys(n);
+    for (auto &key : keys) {
+      // 最低位为 0 的是存在的键，为 1 的用来测查找失败
+      key = rng() & ~uint64_t(1);
+    }
+    std::vector<uint64_t> lookups = keys;
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+    std::vector<uint64_t> misses(n);
+    for (size_t i = 0; i < n; ++i) {
+      misses[i] = keys[i] | 1;
+    }
+
+    for (const auto &r : BenchMap<FlatHashMap<uint64_t, uint64_t>>(
+             "FlatHashMap", keys, lookups, misses)) {
+      print(r, json);
+    }
+    for (const auto &r : BenchMap<std::unordered_map<uint64_t, uint64_t>>(
+             "unordered_map", keys, lookups, misses)) {
+      print(r, json);
+    }
+  }
+}
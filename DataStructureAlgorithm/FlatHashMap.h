@@ -0,0 +1,669 @@
+#ifndef DATA_STRUCTURE_FLAT_HASH_MAP_H
+#define DATA_STRUCTURE_FLAT_HASH_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_HASH_MAP_SSE2 1
+#else
+#define FLAT_HASH_MAP_SSE2 0
+#endif
+
+namespace flat_hash_detail {
+
+/**
+ * 每个槽位一个控制字节：最高位为 1 表示空或已删除，为 0 时低 7 位是哈希值的 H2 部分。
+ */
+using ctrl_t = int8_t;
+
+constexpr ctrl_t kEmpty = -128;   // 0b10000000
+constexpr ctrl_t kDeleted = -2;   // 0b11111110
+
+inline bool is_full(ctrl_t c) { return c >= 0; }
+
+inline int count_trailing_zeros(uint64_t x) { return __builtin_ctzll(x); }
+
+/**
+ * 匹配结果的位掩码，依次取出每个匹配槽位在组内的下标。
+ * Shift 是每个槽位占用的位数的对数（SSE2 为 0，每槽 1 位；可移植实现为 3，每槽 8 位）。
+ */
+template <typename T, int Shift>
+class BitMask {
+ public:
+  explicit BitMask(T mask) : mask_(mask) {}
+
+  explicit operator bool() const { return mask_ != 0; }
+
+  int lowest() const { return count_trailing_zeros(mask_) >> Shift; }
+
+  void clear_lowest() { mask_ &= mask_ - 1; }
+
+ private:
+  T mask_;
+};
+
+#if FLAT_HASH_MAP_SSE2
+/**
+ * 一次比较 16 个控制字节。
+ */
+class Group {
+ public:
+  static constexpr size_t kWidth = 16;
+
+  explicit Group(const ctrl_t *pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  BitMask<uint32_t, 0> match(ctrl_t h2) const {
+    __m128i target = _mm_set1_epi8(h2);
+    return BitMask<uint32_t, 0>(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(target, ctrl_))));
+  }
+
+  BitMask<uint32_t, 0> match_empty() const { return match(kEmpty); }
+
+  // 空和已删除的控制字节都小于 -1
+  BitMask<uint32_t, 0> match_empty_or_deleted() const {
+    __m128i minus_one = _mm_set1_epi8(-1);
+    return BitMask<uint32_t, 0>(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(minus_one, ctrl_))));
+  }
+
+ private:
+  __m128i ctrl_;
+};
+#else
+/**
+ * 没有 SSE2 时一次比较 8 个控制字节（SWAR），每个槽位的结果在对应字节的最高位。
+ * match 可能有误报，调用方总会再比较键，不影响正确性。
+ */
+class Group {
+ public:
+  static constexpr size_t kWidth = 8;
+
+  explicit Group(const ctrl_t *pos) {
+    std::memcpy(&ctrl_, pos, sizeof(ctrl_));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    ctrl_ = __builtin_bswap64(ctrl_);
+#endif
+  }
+
+  BitMask<uint64_t, 3> match(ctrl_t h2) const {
+    uint64_t x = ctrl_ ^ (kLsbs * static_cast<uint8_t>(h2));
+    return BitMask<uint64_t, 3>((x - kLsbs) & ~x & kMsbs);
+  }
+
+  BitMask<uint64_t, 3> match_empty() const {
+    return BitMask<uint64_t, 3>((ctrl_ & ~(ctrl_ << 6)) & kMsbs);
+  }
+
+  BitMask<uint64_t, 3> match_empty_or_deleted() const {
+    return BitMask<uint64_t, 3>((ctrl_ & ~(ctrl_ << 7)) & kMsbs);
+  }
+
+ private:
+  static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+  static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+  uint64_t ctrl_;
+};
+#endif
+
+/**
+ * 二次探测（步长依次加一个组宽），容量为 2 的幂时能访问到所有的组。
+ */
+class ProbeSeq {
+ public:
+  ProbeSeq(size_t hash, size_t mask) : mask_(mask), offset_(hash & mask) {}
+
+  size_t offset() const { return offset_; }
+
+  size_t offset(size_t i) const { return (offset_ + i) & mask_; }
+
+  void next() {
+    index_ += Group::kWidth;
+    offset_ = (offset_ + index_) & mask_;
+  }
+
+ private:
+  size_t mask_;
+  size_t offset_;
+  size_t index_ = 0;
+};
+
+}  // namespace flat_hash_detail
+
+/**
+ * 开放寻址的哈希表（SwissTable 风格），接口是 std::unordered_map 的一个子集。
+ *
+ *  - 元素直接存放在连续的槽位数组中，另有一个控制字节数组记录每个槽位的状态；
+ *  - 哈希值分成 H1（决定探测起点）和 H2（低 7 位，存进控制字节），
+ *    查找时用 SIMD 一次比较一组控制字节，只有 H2 相同的槽位才需要比较键；
+ *  - 最大负载因子 7/8，删除时留下墓碑，墓碑过多时原地重建。
+ * 与 std::unordered_map 的区别：插入导致扩容时所有迭代器和引用失效；
+ * 删除元素不会使其他元素的迭代器失效。
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class FlatHashMap {
+  using ctrl_t = flat_hash_detail::ctrl_t;
+  using Group = flat_hash_detail::Group;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = FlatHashMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference =
+        std::conditional_t<Const, const value_type &, value_type &>;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+    Iterator() = default;
+
+    // iterator 可以隐式转换为 const_iterator
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    Iterator(const Iterator<false> &other)
+        : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {}
+
+    reference operator*() const { return *slot_; }
+
+    pointer operator->() const { return slot_; }
+
+    Iterator &operator++() {
+      ++ctrl_;
+      ++slot_;
+      skip_empty();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.ctrl_ == b.ctrl_;
+    }
+
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return a.ctrl_ != b.ctrl_;
+    }
+
+   private:
+    friend class FlatHashMap;
+    friend class Iterator<!Const>;
+
+    using Slot = std::conditional_t<Const, const value_type, value_type>;
+
+    Iterator(const ctrl_t *ctrl, Slot *slot, const ctrl_t *end)
+        : ctrl_(ctrl), slot_(slot), end_(end) {}
+
+    void skip_empty() {
+      while (ctrl_ != end_ && !flat_hash_detail::is_full(*ctrl_)) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const ctrl_t *ctrl_ = nullptr;
+    Slot *slot_ = nullptr;
+    const ctrl_t *end_ = nullptr;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+
+  explicit FlatHashMap(size_t bucket_count, const Hash &hash = Hash(),
+                       const KeyEqual &eq = KeyEqual())
+      : hash_(hash), eq_(eq) {
+    reserve(bucket_count);
+  }
+
+  FlatHashMap(std::initializer_list<value_type> init) {
+    reserve(init.size());
+    for (const auto &value : init) {
+      insert(value);
+    }
+  }
+
+  FlatHashMap(const FlatHashMap &other) : hash_(other.hash_), eq_(other.eq_) {
+    reserve(other.size());
+    try {
+      for (const auto &value : other) {
+        insert_unique(hash_of(value.first), value);
+      }
+    } catch (...) {
+      // 构造函数抛出时析构函数不会运行，已拷贝的元素要在这里析构
+      destroy_slots();
+      throw;
+    }
+  }
+
+  FlatHashMap(FlatHashMap &&other) noexcept
+      : ctrl_(std::move(other.ctrl_)),
+        slots_(std::move(other.slots_)),
+        capacity_(other.capacity_),
+        size_(other.size_),
+        growth_left_(other.growth_left_),
+        hash_(std::move(other.hash_)),
+        eq_(std::move(other.eq_)) {
+    other.capacity_ = other.size_ = other.growth_left_ = 0;
+  }
+
+  FlatHashMap &operator=(const FlatHashMap &other) {
+    if (this != &other) {
+      FlatHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatHashMap &operator=(FlatHashMap &&other) noexcept {
+    if (this != &other) {
+      destroy_slots();
+      ctrl_ = std::move(other.ctrl_);
+      slots_ = std::move(other.slots_);
+      capacity_ = other.capacity_;
+      size_ = other.size_;
+      growth_left_ = other.growth_left_;
+      hash_ = std::move(other.hash_);
+      eq_ = std::move(other.eq_);
+      other.capacity_ = other.size_ = other.growth_left_ = 0;
+    }
+    return *this;
+  }
+
+  ~FlatHashMap() { destroy_slots(); }
+
+  iterator begin() {
+    iterator it(ctrl_.get(), slot(0), ctrl_.get() + capacity_);
+    it.skip_empty();
+    return it;
+  }
+
+  iterator end() {
+    return iterator(ctrl_.get() + capacity_, slot(capacity_),
+                    ctrl_.get() + capacity_);
+  }
+
+  const_iterator begin() const { return const_cast<FlatHashMap *>(this)->begin(); }
+
+  const_iterator end() const { return const_cast<FlatHashMap *>(this)->end(); }
+
+  const_iterator cbegin() const { return begin(); }
+
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+
+  size_t size() const { return size_; }
+
+  /**
+   * 槽位总数，不扩容最多能放下 capacity() * 7 / 8 个元素。
+   */
+  size_t capacity() const { return capacity_; }
+
+  float load_factor() const {
+    return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / capacity_;
+  }
+
+  void clear() {
+    destroy_slots();
+    if (capacity_ > 0) {
+      std::memset(ctrl_.get(), flat_hash_detail::kEmpty,
+                  capacity_ + Group::kWidth);
+    }
+    size_ = 0;
+    growth_left_ = max_growth(capacity_);
+  }
+
+  /**
+   * 保证放下 count 个元素之前不会扩容。
+   */
+  void reserve(size_t count) {
+    size_t cap = capacity_ == 0 ? Group::kWidth : capacity_;
+    while (max_growth(cap) < count) {
+      cap *= 2;
+    }
+    if (cap > capacity_) {
+      resize(cap);
+    }
+  }
+
+  /**
+   * 与 std::unordered_map 的 rehash 不同，参数是元素个数而不是桶数。
+   */
+  void rehash(size_t count) { reserve(std::max(count, size_)); }
+
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  /**
+   * 先构造出元素再查找，键已存在时丢弃；已知键时 try_emplace 更快。
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(std::move(value));
+  }
+
+  /**
+   * 键不存在时才用 args 构造值。
+   */
+  template <typename KeyArg, typename... Args>
+  std::pair<iterator, bool> try_emplace(KeyArg &&key, Args &&...args) {
+    size_t hash = hash_of(key);
+    size_t index;
+    if (find_index(key, hash, index)) {
+      return {iterator_at(index), false};
+    }
+    index = prepare_insert(hash);
+    new (slot(index)) value_type(std::piecewise_construct,
+                                 std::forward_as_tuple(std::forward<KeyArg>(key)),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+    commit_insert(index, hash);
+    return {iterator_at(index), true};
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const K &key, M &&value) {
+    auto result = try_emplace(key, std::forward<M>(value));
+    if (!result.second) {
+      result.first->second = std::forward<M>(value);
+    }
+    return result;
+  }
+
+  V &operator[](const K &key) { return try_emplace(key).first->second; }
+
+  V &operator[](K &&key) { return try_emplace(std::move(key)).first->second; }
+
+  V &at(const K &key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatHashMap::at: key not found");
+    }
+    return it->second;
+  }
+
+  const V &at(const K &key) const {
+    return const_cast<FlatHashMap *>(this)->at(key);
+  }
+
+  iterator find(const K &key) {
+    size_t index;
+    if (find_index(key, hash_of(key), index)) {
+      return iterator_at(index);
+    }
+    return end();
+  }
+
+  const_iterator find(const K &key) const {
+    return const_cast<FlatHashMap *>(this)->find(key);
+  }
+
+  bool contains(const K &key) const { return find(key) != end(); }
+
+  size_t count(const K &key) const { return contains(key) ? 1 : 0; }
+
+  size_t erase(const K &key) {
+    size_t index;
+    if (!find_index(key, hash_of(key), index)) {
+      return 0;
+    }
+    erase_at(index);
+    return 1;
+  }
+
+  /**
+   * 返回下一个元素的迭代器，可以在遍历时删除。
+   */
+  iterator erase(const_iterator pos) {
+    size_t index = pos.ctrl_ - ctrl_.get();
+    erase_at(index);
+    iterator next = iterator_at(index);
+    next.skip_empty();
+    return next;
+  }
+
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  void swap(FlatHashMap &other) noexcept {
+    using std::swap;
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+    swap(hash_, other.hash_);
+    swap(eq_, other.eq_);
+  }
+
+  hasher hash_function() const { return hash_; }
+
+  key_equal key_eq() const { return eq_; }
+
+ private:
+  struct Slot {
+    alignas(value_type) unsigned char bytes[sizeof(value_type)];
+  };
+
+  // 负载因子上限 7/8
+  static size_t max_growth(size_t capacity) { return capacity - capacity / 8; }
+
+  /**
+   * std::hash 对整数是恒等映射，低位和高位的分布都很差，先混合一次。
+   */
+  size_t hash_of(const K &key) const {
+    uint64_t h = static_cast<uint64_t>(hash_(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  static size_t h1(size_t hash) { return hash >> 7; }
+
+  static ctrl_t h2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+
+  value_type *slot(size_t index) {
+    return std::launder(reinterpret_cast<value_type *>(slots_.get() + index));
+  }
+
+  iterator iterator_at(size_t index) {
+    return iterator(ctrl_.get() + index, slot(index), ctrl_.get() + capacity_);
+  }
+
+  /**
+   * 控制字节数组末尾多出一个组宽，复制开头的控制字节，
+   * 这样从任意位置开始读一整组都不会越界，也不需要处理回绕。
+   */
+  void set_ctrl(size_t index, ctrl_t h) {
+    ctrl_[index] = h;
+    if (index < Group::kWidth) {
+      ctrl_[capacity_ + index] = h;
+    }
+  }
+
+  bool find_index(const K &key, size_t hash, size_t &index) const {
+    if (capacity_ == 0) {
+      return false;
+    }
+    auto *self = const_cast<FlatHashMap *>(this);
+    flat_hash_detail::ProbeSeq seq(h1(hash), capacity_ - 1);
+    while (true) {
+      Group group(ctrl_.get() + seq.offset());
+      for (auto match = group.match(h2(hash)); match; match.clear_lowest()) {
+        size_t i = seq.offset(match.lowest());
+        if (eq_(self->slot(i)->first, key)) {
+          index = i;
+          return true;
+        }
+      }
+      // 组内有空槽位说明键不存在（删除留下的是墓碑，不会截断探测序列）
+      if (group.match_empty()) {
+        return false;
+      }
+      seq.next();
+    }
+  }
+
+  size_t find_first_non_full(size_t hash) const {
+    flat_hash_detail::ProbeSeq seq(h1(hash), capacity_ - 1);
+    while (true) {
+      Group group(ctrl_.get() + seq.offset());
+      auto mask = group.match_empty_or_deleted();
+      if (mask) {
+        return seq.offset(mask.lowest());
+      }
+      seq.next();
+    }
+  }
+
+  /**
+   * 为 hash 找一个可以写入的槽位，必要时扩容，返回槽位下标。
+   * 控制字节和计数留给 commit_insert，元素构造抛异常时表保持不变。
+   */
+  size_t prepare_insert(size_t hash) {
+    if (capacity_ == 0) {
+      resize(Group::kWidth);
+    }
+    size_t index = find_first_non_full(hash);
+    if (growth_left_ == 0 && ctrl_[index] != flat_hash_detail::kDeleted) {
+      // 墓碑超过一半时原地重建就能腾出空间，否则扩容
+      resize(size_ * 2 < max_growth(capacity_) ? capacity_ : capacity_ * 2);
+      index = find_first_non_full(hash);
+    }
+    return index;
+  }
+
+  /**
+   * 元素已在 index 处构造好之后再标记槽位。
+   */
+  void commit_insert(size_t index, size_t hash) {
+    if (ctrl_[index] == flat_hash_detail::kEmpty) {
+      --growth_left_;
+    }
+    set_ctrl(index, h2(hash));
+    ++size_;
+  }
+
+  /**
+   * 已知键不存在时直接插入，用于拷贝构造。
+   */
+  void insert_unique(size_t hash, const value_type &value) {
+    size_t index = prepare_insert(hash);
+    new (slot(index)) value_type(value);
+    commit_insert(index, hash);
+  }
+
+  /**
+   * 如果所有覆盖 index 的组里都还有空槽位，说明没有探测序列越过过这个位置，
+   * 可以直接标记为空；否则留下墓碑。
+   */
+  void erase_at(size_t index) {
+    slot(index)->~value_type();
+    --size_;
+    size_t mask = capacity_ - 1;
+    size_t after = 1;
+    while (after < Group::kWidth &&
+           ctrl_[(index + after) & mask] != flat_hash_detail::kEmpty) {
+      ++after;
+    }
+    size_t before = 1;
+    while (before < Group::kWidth &&
+           ctrl_[(index - before) & mask] != flat_hash_detail::kEmpty) {
+      ++before;
+    }
+    if (after + before <= Group::kWidth) {
+      set_ctrl(index, flat_hash_detail::kEmpty);
+      ++growth_left_;
+    } else {
+      set_ctrl(index, flat_hash_detail::kDeleted);
+    }
+  }
+
+  void resize(size_t new_capacity) {
+    std::unique_ptr<ctrl_t[]> old_ctrl = std::move(ctrl_);
+    std::unique_ptr<Slot[]> old_slots = std::move(slots_);
+    size_t old_capacity = capacity_;
+
+    ctrl_.reset(new ctrl_t[new_capacity + Group::kWidth]);
+    std::memset(ctrl_.get(), flat_hash_detail::kEmpty,
+                new_capacity + Group::kWidth);
+    slots_.reset(new Slot[new_capacity]);
+    capacity_ = new_capacity;
+    growth_left_ = max_growth(new_capacity) - size_;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (!flat_hash_detail::is_full(old_ctrl[i])) {
+        continue;
+      }
+      auto *old = std::launder(reinterpret_cast<value_type *>(old_slots.get() + i));
+      size_t hash = hash_of(old->first);
+      size_t index = find_first_non_full(hash);
+      set_ctrl(index, h2(hash));
+      // 旧元素随后就析构，把 const 键移走是安全的
+      new (slot(index)) value_type(std::move(const_cast<K &>(old->first)),
+                                   std::move(old->second));
+      old->~value_type();
+    }
+  }
+
+  void destroy_slots() {
+    if constexpr (!std::is_trivially_destructible<value_type>::value) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (flat_hash_detail::is_full(ctrl_[i])) {
+          slot(i)->~value_type();
+        }
+      }
+    }
+  }
+
+  std::unique_ptr<ctrl_t[]> ctrl_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left_ = 0;
+  Hash hash_;
+  KeyEqual eq_;
+};
+
+#endif /* DATA_STRUCTURE_FLAT_HASH_MAP_H */
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CircleQueue.h"
+#include "MpmcQueue.h"
+
+/**
+ * 多个生产者和消费者通过容量很小的队列传递元素，检查：
+ * 每个元素恰好被取出一次，且每个消费者看到的同一生产者的元素是递增的。
+ */
+template <typename Queue>
+bool StressTest(Queue &que, int producers, int consumers, long per_producer) {
+  // 元素编码为 producer * per_producer + seq，-1 表示结束
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+  std::atomic<bool> ordered{true};
+
+  std::vector<std::thread> threads;
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&, producers, per_producer]() {
+      std::vector<long> last(producers, -1);
+      while (true) {
+        long x = que.pop();
+        if (x < 0) {
+          break;
+        }
+        long producer = x / per_producer;
+        long seq = x % per_producer;
+        if (seq <= last[producer]) {
+          ordered = false;
+        }
+        last[producer] = seq;
+        seen[x].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  std::vector<std::thread> producer_threads;
+  for (int p = 0; p < producers; ++p) {
+    producer_threads.emplace_back([&que, p, per_producer]() {
+      for (long i = 0; i < per_producer; ++i) {
+        que.push(p * per_producer + i);
+      }
+    });
+  }
+  for (auto &t : producer_threads) {
+    t.join();
+  }
+  for (int c = 0; c < consumers; ++c) {
+    que.push(-1);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  bool exactly_once = std::all_of(seen.begin(), seen.end(),
+                                  [](const std::atomic<int> &n) {
+                                    return n.load() == 1;
+                                  });
+  return exactly_once && ordered;
+}
+
+/**
+ * 让非阻塞的 MpmcQueue 具有和阻塞队列一样的接口，队列满（空）时让出 CPU 重试。
+ */
+template <typename T>
+class YieldingMpmcQueue {
+ public:
+  explicit YieldingMpmcQueue(size_t capacity) : queue_(capacity) {}
+
+  void push(T value) {
+    while (!queue_.push(value)) {
+      std::this_thread::yield();
+    }
+  }
+
+  T pop() {
+    T value;
+    while (!queue_.pop(value)) {
+      std::this_thread::yield();
+    }
+    return value;
+  }
+
+ private:
+  MpmcQueue<T> queue_;
+};
+
+/**
+ * 用互斥量和条件变量保护的 CircleQueue，作为对照。
+ */
+template <typename T>
+class LockedCircleQueue {
+ public:
+  explicit LockedCircleQueue(int capacity) : que_(capacity) {}
+
+  void push(T value) {
+    std::unique_lock<std::mutex> locker(mtx_);
+    not_full_.wait(locker, [this]() { return !que_.full(); });
+    que_.push(value);
+    not_empty_.notify_one();
+  }
+
+  T pop() {
+    std::unique_lock<std::mutex> locker(mtx_);
+    not_empty_.wait(locker, [this]() { return !que_.empty(); });
+    T value = que_.front();
+    que_.pop();
+    not_full_.notify_one();
+    return value;
+  }
+
+ private:
+  std::mutex mtx_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  CircleQueue<T> que_;
+};
+
+void TestMpmcQueue() {
+  MpmcQueue<std::string> que(3);
+  std::cout << "que.capacity() = " << que.capacity() << std::endl;
+  int pushed = 0;
+  while (que.push(std::to_string(pushed))) {
+    ++pushed;
+  }
+  std::cout << "pushed until full: " << pushed << std::endl;
+  std::string value;
+  while (que.pop(value)) {
+    std::cout << value << " ";
+  }
+  std::cout << std::endl;
+
+  YieldingMpmcQueue<long> yielding(8);
+  BlockingMpmcQueue<long> blocking(8);
+  std::cout << "stress MpmcQueue: "
+            << (StressTest(yielding, 4, 4, 50000) ? "ok" : "FAILED")
+            << std::endl;
+  std::cout << "stress BlockingMpmcQueue: "
+            << (StressTest(blocking, 4, 4, 50000) ? "ok" : "FAILED")
+            << std::endl;
+}
+
+/**
+ * threads 个线程一半生产一半消费（至少各一个），共传递 n 个元素，返回每秒传递的元素数。
+ */
+template <typename Queue>
+double Throughput(int threads, long n) {
+  Queue que(1024);
+  int producers = std::max(1, threads / 2);
+  int consumers = std::max(1, threads - producers);
+  long per_producer = n / producers;
+  long total = per_producer * producers;
+  long per_consumer = total / consumers;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int c = 0; c < consumers; ++c) {
+    long count = c == 0 ? total - per_consumer * (consumers - 1) : per_consumer;
+    workers.emplace_back([&que, count]() {
+      for (long i = 0; i < count; ++i) {
+        que.pop();
+      }
+    });
+  }
+  for (int p = 0; p < producers; ++p) {
+    workers.emplace_back([&que, per_producer]() {
+      for (long i = 0; i < per_producer; ++i) {
+        que.push(i);
+      }
+    });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return total / seconds;
+}
+
+void BenchmarkMpmcQueue(long n) {
+  std::cout << "threads,MpmcQueue,BlockingMpmcQueue,mutex+CircleQueue (ops/s)"
+            << std::endl;
+  for (int threads : {1, 2, 4, 8, 16, 32}) {
+    std::cout << threads << "," << Throughput<YieldingMpmcQueue<long>>(threads, n)
+              << "," << Throughput<BlockingMpmcQueue<long>>(threads, n) << ","
+              << Throughput<LockedCircleQueue<long>>(threads, n) << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  TestMpmcQueue();
+  long n = argc > 1 ? std::stol(argv[1]) : 2000000;
+  BenchmarkMpmcQueue(n);
+}
@@ -0,0 +1,240 @@
+#ifndef DATA_STRUCTURE_MPMC_QUEUE_H
+#define DATA_STRUCTURE_MPMC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * 多生产者多消费者的有界无锁队列（Dmitry Vyukov 的算法）。
+ *
+ * 每个槽位带一个序号：序号等于 pos 表示槽位空闲、可以写入第 pos 个元素，
+ * 等于 pos + 1 表示第 pos 个元素已经写好、可以读取。生产者和消费者各自用 CAS
+ * 抢占下标，之后只访问抢到的槽位，不同槽位上的操作互不干扰。
+ * 接口与 CircleQueue 保持一致，pop 通过参数返回队首元素。
+ */
+template <typename T>
+class MpmcQueue {
+ public:
+  static constexpr size_t kCacheLine = 64;
+
+  explicit MpmcQueue(size_t capacity) {
+    if (capacity == 0) {
+      throw std::length_error("cannot create a MpmcQueue with capacity 0");
+    }
+    size_t n = 2;
+    while (n < capacity) {
+      n <<= 1;
+    }
+    mask_ = n - 1;
+    cells_.reset(new Cell[n]);
+    for (size_t i = 0; i < n; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) {
+      std::launder(reinterpret_cast<T *>(cells_[head & mask_].storage))->~T();
+    }
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+  /**
+   * 队列满时返回 false，此时参数不会被移动。
+   */
+  template <typename... Args>
+  bool emplace(Args &&...args) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    new (cell->storage) T(std::forward<Args>(args)...);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool push(const T &value) { return emplace(value); }
+
+  bool push(T &&value) { return emplace(std::move(value)); }
+
+  /**
+   * 队列空时返回 false。
+   */
+  bool pop(T &value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T *p = std::launder(reinterpret_cast<T *>(cell->storage));
+    value = std::move(*p);
+    p->~T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * 并发访问时只是近似值。
+   */
+  size_t size() const {
+    size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+    size_t head = dequeue_pos_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  bool full() const { return size() >= capacity(); }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  size_t mask_ = 0;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+  alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+};
+
+/**
+ * 在 MpmcQueue 外面加上阻塞语义：队列满（空）时先自旋一小段时间，
+ * 仍然不行再在条件变量上休眠。没有线程休眠时，push/pop 不会访问互斥量。
+ */
+template <typename T>
+class BlockingMpmcQueue {
+ public:
+  explicit BlockingMpmcQueue(size_t capacity, int spin = 64)
+      : queue_(capacity), spin_(spin) {}
+
+  void push(T value) {
+    if (!spin_until([&]() { return queue_.push(std::move(value)); })) {
+      std::unique_lock<std::mutex> locker(mtx_);
+      push_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_full_.wait(locker, [&]() { return queue_.push(std::move(value)); });
+      push_waiters_.fetch_sub(1);
+    }
+    wake(pop_waiters_, not_empty_);
+  }
+
+  T pop() {
+    T value;
+    if (!spin_until([&]() { return queue_.pop(value); })) {
+      std::unique_lock<std::mutex> locker(mtx_);
+      pop_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_empty_.wait(locker, [&]() { return queue_.pop(value); });
+      pop_waiters_.fetch_sub(1);
+    }
+    wake(push_waiters_, not_full_);
+    return value;
+  }
+
+  bool try_push(T value) {
+    if (!queue_.push(std::move(value))) {
+      return false;
+    }
+    wake(pop_waiters_, not_empty_);
+    return true;
+  }
+
+  bool try_pop(T &value) {
+    if (!queue_.pop(value)) {
+      return false;
+    }
+    wake(push_waiters_, not_full_);
+    return true;
+  }
+
+  size_t size() const { return queue_.size(); }
+
+  size_t capacity() const { return queue_.capacity(); }
+
+ private:
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  template <typename F>
+  bool spin_until(F &&f) {
+    for (int i = 0; i <= spin_; ++i) {
+      if (f()) {
+        return true;
+      }
+      cpu_relax();
+    }
+    return false;
+  }
+
+  /**
+   * 与休眠方的 “登记等待者 -> 再检查队列” 构成 Dekker 式的同步：
+   * 要么休眠方再检查时看到了新状态，要么这里看到了等待者并在锁内通知。
+   */
+  void wake(std::atomic<int> &waiters, std::condition_variable &cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> locker(mtx_);
+      cv.notify_one();
+    }
+  }
+
+  MpmcQueue<T> queue_;
+  int spin_;
+  std::mutex mtx_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::atomic<int> push_waiters_{0};
+  std::atomic<int> pop_waiters_{0};
+};
+
+#endif /* DATA_STRUCTURE_MPMC_QUEUE_H */
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ShardedCache.h"
+
+// 例如一段推理结果，64 字节
+struct Embedding {
+  uint64_t key = 0;
+  float data[14] = {};
+};
+
+Embedding MakeValue(uint64_t key) {
+  Embedding e;
+  e.key = key;
+  for (int i = 0; i < 14; ++i) {
+    e.data[i] = static_cast<float>(key % 1000 + i);
+  }
+  return e;
+}
+
+bool Consistent(uint64_t key, const Embedding &e) {
+  return e.key == key && e.data[13] == static_cast<float>(key % 1000 + 13);
+}
+
+/**
+ * 单线程检查替换、删除和字节预算；多线程时读者检查读到的值没有被撕裂或提前释放。
+ */
+void TestShardedCache() {
+  constexpr size_t kCharge = 128;
+  ShardedCache<uint64_t, Embedding> cache(64 * kCharge, 64, 4);
+  bool ok = true;
+  for (uint64_t k = 0; k < 1000; ++k) {
+    cache.insert(k, MakeValue(k), kCharge);
+    ok = ok && cache.usage() <= cache.capacity();
+  }
+  Embedding e;
+  ok = ok && cache.get(999, e) && Consistent(999, e);
+  ok = ok && !cache.get(0, e);
+  cache.insert(999, MakeValue(7), kCharge);
+  ok = ok && cache.get(999, e) && e.key == 7;
+  ok = ok && cache.erase(999) && !cache.erase(999) && !cache.contains(999);
+  ok = ok && !cache.insert(1, MakeValue(1), cache.capacity());
+  std::cout << "single thread ok = " << ok << ", size = " << cache.size()
+            << ", usage = " << cache.usage() << "/" << cache.capacity()
+            << std::endl;
+
+  // 经常被访问的键应该比只插入一次的键更容易留下来
+  ShardedCache<uint64_t, Embedding> clock(100 * kCharge, 100, 1);
+  for (uint64_t k = 0; k < 50; ++k) {
+    clock.insert(k, MakeValue(k), kCharge);
+  }
+  int hot_kept = 0;
+  for (uint64_t k = 1000; k < 2000; ++k) {
+    for (uint64_t hot = 0; hot < 50; ++hot) {
+      clock.get(hot, e);
+    }
+    clock.insert(k, MakeValue(k), kCharge);
+  }
+  for (uint64_t hot = 0; hot < 50; ++hot) {
+    hot_kept += clock.contains(hot);
+  }
+  std::cout << "hot keys kept by CLOCK = " << hot_kept << "/50" << std::endl;
+
+  ShardedCache<uint64_t, Embedding> shared(256 * kCharge, 256, 8);
+  std::atomic<int> torn{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&shared, &torn, t]() {
+      std::mt19937_64 rng(t);
+      Embedding value;
+      for (int i = 0; i < 100000; ++i) {
+        uint64_t key = rng() % 1024;
+        if (shared.get(key, value)) {
+          if (!Consistent(key, value)) {
+            torn.fetch_add(1, std::memory_order_relaxed);
+          }
+        } else {
+          shared.insert(key, MakeValue(key), kCharge);
+        }
+        if (i % 97 == 0) {
+          shared.erase(rng() % 1024);
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::cout << "concurrent: torn reads = " << torn
+            << ", usage = " << shared.usage() << "/" << shared.capacity()
+            << std::endl;
+}
+
+/**
+ * 整个缓存一把锁的 LRU（std::list + std::unordered_map），shards 大于 1 时按键分片。
+ */
+class LockedLruCache {
+ public:
+  LockedLruCache(size_t capacity_bytes, size_t shards)
+      : shards_(shards), capacity_(capacity_bytes / shards) {}
+
+  bool get(uint64_t key, Embedding &value) {
+    Shard &s = shards_[std::hash<uint64_t>()(key) % shards_.size()];
+    std::lock_guard<std::mutex> locker(s.mtx);
+    auto it = s.index.find(key);
+    if (it == s.index.end()) {
+      return false;
+    }
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    value = it->second->second;
+    return true;
+  }
+
+  void insert(uint64_t key, const Embedding &value, size_t charge) {
+    Shard &s = shards_[std::hash<uint64_t>()(key) % shards_.size()];
+    std::lock_guard<std::mutex> locker(s.mtx);
+    auto it = s.index.find(key);
+    if (it != s.index.end()) {
+      it->second->second = value;
+      s.lru.splice(s.lru.begin(), s.lru, it->second);
+      return;
+    }
+    s.lru.emplace_front(key, value);
+    s.index[key] = s.lru.begin();
+    s.usage += charge;
+    while (s.usage > capacity_) {
+      s.index.erase(s.lru.back().first);
+      s.lru.pop_back();
+      s.usage -= charge;
+    }
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::mutex mtx;
+    std::list<std::pair<uint64_t, Embedding>> lru;
+    std::unordered_map<uint64_t,
+                       std::list<std::pair<uint64_t, Embedding>>::iterator>
+        index;
+    size_t usage = 0;
+  };
+
+  std::vector<Shard> shards_;
+  size_t capacity_;
+};
+
+/**
+ * YCSB 的 Zipf 分布生成器（Gray 等人的方法），返回 [0, n)，0 最热。
+ */
+class ZipfGenerator {
+ public:
+  ZipfGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+    double zeta2 = 0;
+    for (uint64_t i = 1; i <= n; ++i) {
+      double term = 1.0 / std::pow(static_cast<double>(i), theta);
+      zetan_ += term;
+      if (i <= 2) {
+        zeta2 += term;
+      }
+    }
+    alpha_ = 1.0 / (1.0 - theta);
+    eta_ = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+  }
+
+  template <typename Rng>
+  uint64_t operator()(Rng &rng) const {
+    double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    return std::min<uint64_t>(
+        n_ - 1, static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1,
+                                                     alpha_)));
+  }
+
+ private:
+  uint64_t n_;
+  double theta_;
+  double zetan_ = 0;
+  double alpha_ = 0;
+  double eta_ = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string cache;
+  int threads = 0;
+  uint64_t ops = 0;
+  double seconds = 0;
+  uint64_t hits = 0;
+
+  double ops_per_sec() const { return ops / seconds; }
+  double hit_rate() const { return static_cast<double>(hits) / ops; }
+};
+
+/**
+ * 每次访问先 get，未命中时插入（相当于重新计算后写回缓存）。
+ * 键按 Zipf 分布抽取，并预先生成好，不计入时间。
+ */
+template <typename Cache>
+Result Bench(const std::string &name, Cache &cache, int threads,
+             const std::vector<uint64_t> &keys, size_t charge) {
+  auto access = [&cache, charge](uint64_t key, Embedding &value) {
+    if (cache.get(key, value)) {
+      return true;
+    }
+    cache.insert(key, MakeValue(key), charge);
+    return false;
+  };
+  // 先用一遍访问序列预热
+  Embedding value;
+  for (uint64_t key : keys) {
+    access(key, value);
+  }
+
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::atomic<uint64_t> hits{0};
+  std::vector<std::thread> workers;
+  size_t per_thread = keys.size() / threads;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      Embedding value;
+      uint64_t local_hits = 0;
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      // 各线程从访问序列的不同位置开始
+      for (size_t i = 0; i < per_thread; ++i) {
+        local_hits += access(keys[(t * per_thread + i) % keys.size()], value);
+      }
+      hits.fetch_add(local_hits);
+    });
+  }
+  while (ready.load() < threads) {
+    std::this_thread::yield();
+  }
+  auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &w : workers) {
+    w.join();
+  }
+  Result r;
+  r.cache = name;
+  r.threads = threads;
+  r.ops = per_thread * threads;
+  r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  r.hits = hits.load();
+  return r;
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"cache\":\"" << r.cache << "\",\"threads\":" << r.threads
+              << ",\"ops\":" << r.ops << ",\"seconds\":" << r.seconds
+              << ",\"ops_per_sec\":" << r.ops_per_sec()
+              << ",\"hit_rate\":" << r.hit_rate() << "}" << std::endl;
+  } else {
+    std::cout << r.cache << "," << r.threads << "," << r.ops << ","
+              << r.seconds << "," << r.ops_per_sec() << "," << r.hit_rate()
+              << std::endl;
+  }
+}
+
+std::vector<int> powers_of_two(int max) {
+  std::vector<int> counts;
+  for (int n = 1; n < max; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max);
+  return counts;
+}
+
+/**
+ *   ./ShardedCache [--json] [--max-threads=N] [--ops=N] [--keys=N] [--theta=X]
+ * 键空间默认 1M 个键，缓存能放下 10%，Zipf 参数默认 0.99；
+ * 线程数从 1 按 2 倍增加到 max-threads（默认 64）。
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int max_threads = 64;
+  uint64_t ops = 2000000;
+  uint64_t num_keys = 1000000;
+  double theta = 0.99;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-threads=", 0) == 0) {
+      max_threads = std::max(1, std::stoi(arg.substr(14)));
+    } else if (arg.rfind("--ops=", 0) == 0) {
+      ops = std::max<uint64_t>(1, std::stoull(arg.substr(6)));
+    } else if (arg.rfind("--keys=", 0) == 0) {
+      num_keys = std::max<uint64_t>(10, std::stoull(arg.substr(7)));
+    } else if (arg.rfind("--theta=", 0) == 0) {
+      theta = std::stod(arg.substr(8));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--json] [--max-threads=N] [--ops=N] [--keys=N]"
+                   " [--theta=X]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestShardedCache();
+    std::cout << "cache,threads,ops,seconds,ops_per_sec,hit_rate" << std::endl;
+  }
+
+  // 两种缓存都按每个条目 128 字节计费，预算相同时能放下的条目数相同
+  constexpr size_t kCharge = 128;
+  size_t capacity_bytes = num_keys / 10 * kCharge;
+  ZipfGenerator zipf(num_keys, theta);
+  std::mt19937_64 rng(2024);
+  std::vector<uint64_t> keys(ops);
+  for (auto &key : keys) {
+    // 打散热点键，避免热度和键值相关
+    key = zipf(rng) * 0x9e3779b97f4a7c15ULL;
+  }
+
+  for (int threads : powers_of_two(max_threads)) {
+    {
+      ShardedCache<uint64_t, Embedding> cache(capacity_bytes, num_keys / 10);
+      print(Bench("clock_sharded", cache, threads, keys, kCharge), json);
+    }
+    {
+      LockedLruCache cache(capacity_bytes, 1);
+      print(Bench("lru_global_lock", cache, threads, keys, kCharge), json);
+    }
+    {
+      LockedLruCache cache(capacity_bytes, 64);
+      print(Bench("lru_sharded", cache, threads, keys, kCharge), json);
+    }
+  }
+}
@@ -0,0 +1,312 @@
+#ifndef DATA_STRUCTURE_SHARDED_CACHE_H
+#define DATA_STRUCTURE_SHARDED_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../MemoryModel/EpochReclamation.h"
+
+/**
+ * 分片的并发缓存，按字节预算淘汰，淘汰算法为 CLOCK。
+ *
+ * 键按哈希值的高位分到各个分片，每个分片有自己的互斥锁、链式哈希桶和 CLOCK 环。
+ * 查找不加锁：在纪元回收的保护下沿桶链表读取，命中时只在引用位为 0 时写一次，
+ * 热点条目的命中不会写共享的缓存行。插入、替换和删除持分片锁，摘下的节点交给
+ * EpochDomain 延迟释放，所以读者拿到的节点在读完之前不会被释放。
+ * 节点一旦发布就不再修改，替换时换成新节点，get 返回值的拷贝。
+ *
+ * 每个分片的桶数在构造时按 expected_entries 确定，之后不再扩容，
+ * 条目数超出预期时只是链表变长。
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class ShardedCache {
+ private:
+  struct Node;
+
+ public:
+  /**
+   * capacity_bytes 平均分给各分片；shards 为 0 时取 CPU 核数的 4 倍，都向上取 2 的幂。
+   */
+  ShardedCache(size_t capacity_bytes, size_t expected_entries,
+               size_t shards = 0)
+      : capacity_(capacity_bytes) {
+    if (shards == 0) {
+      shards = 4 * std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t num_shards = round_up(shards);
+    shard_mask_ = num_shards - 1;
+    size_t buckets =
+        round_up(std::max<size_t>(expected_entries / num_shards, 8));
+    shards_.reset(new Shard[num_shards]);
+    for (size_t i = 0; i < num_shards; ++i) {
+      Shard &s = shards_[i];
+      s.capacity = capacity_bytes / num_shards;
+      s.mask = buckets - 1;
+      s.buckets.reset(new std::atomic<Node *>[buckets]);
+      for (size_t b = 0; b < buckets; ++b) {
+        s.buckets[b].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * 析构时不能再有其他线程访问。
+   */
+  ~ShardedCache() {
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      for (Node *node : shards_[i].clock) {
+        delete node;
+      }
+    }
+  }
+
+  ShardedCache(const ShardedCache &) = delete;
+  ShardedCache &operator=(const ShardedCache &) = delete;
+
+  /**
+   * 命中时把值拷贝到 value，不加锁。
+   */
+  bool get(const K &key, V &value) {
+    uint64_t h = hash_of(key);
+    Shard &s = shard_for(h);
+    EpochGuard guard;
+    for (Node *p = s.buckets[h & s.mask].load(std::memory_order_acquire);
+         p != nullptr; p = p->next.load(std::memory_order_acquire)) {
+      if (p->hash == h && eq_(p->key, key)) {
+        if (!p->referenced.load(std::memory_order_relaxed)) {
+          p->referenced.store(true, std::memory_order_relaxed);
+        }
+        value = p->value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool contains(const K &key) {
+    uint64_t h = hash_of(key);
+    Shard &s = shard_for(h);
+    EpochGuard guard;
+    for (Node *p = s.buckets[h & s.mask].load(std::memory_order_acquire);
+         p != nullptr; p = p->next.load(std::memory_order_acquire)) {
+      if (p->hash == h && eq_(p->key, key)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * 插入或替换。charge 是这个条目计入预算的字节数，为 0 时按节点本身的大小计算；
+   * 超过单个分片的预算时不插入并返回 false。必要时淘汰同一分片中的其他条目。
+   */
+  bool insert(const K &key, V value, size_t charge = 0) {
+    uint64_t h = hash_of(key);
+    Shard &s = shard_for(h);
+    if (charge == 0) {
+      charge = sizeof(Node);
+    }
+    if (charge > s.capacity) {
+      return false;
+    }
+    Node *node = new Node(key, std::move(value), h, charge);
+
+    std::lock_guard<std::mutex> locker(s.mtx);
+    std::atomic<Node *> *link = find_link(s, h, key);
+    Node *old = link->load(std::memory_order_relaxed);
+    if (old != nullptr) {
+      node->next.store(old->next.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+      node->referenced.store(true, std::memory_order_relaxed);
+      node->clock_index = old->clock_index;
+      s.clock[node->clock_index] = node;
+      link->store(node, std::memory_order_release);
+      s.usage.store(s.usage.load(std::memory_order_relaxed) - old->charge,
+                    std::memory_order_relaxed);
+      EpochDomain::instance().retire(old);
+    } else {
+      std::atomic<Node *> &head = s.buckets[h & s.mask];
+      node->next.store(head.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+      node->clock_index = s.clock.size();
+      s.clock.push_back(node);
+      s.count.store(s.clock.size(), std::memory_order_relaxed);
+      head.store(node, std::memory_order_release);
+    }
+    s.usage.store(s.usage.load(std::memory_order_relaxed) + charge,
+                  std::memory_order_relaxed);
+    while (s.usage.load(std::memory_order_relaxed) > s.capacity) {
+      evict_one(s, node);
+    }
+    return true;
+  }
+
+  bool erase(const K &key) {
+    uint64_t h = hash_of(key);
+    Shard &s = shard_for(h);
+    std::lock_guard<std::mutex> locker(s.mtx);
+    std::atomic<Node *> *link = find_link(s, h, key);
+    Node *node = link->load(std::memory_order_relaxed);
+    if (node == nullptr) {
+      return false;
+    }
+    remove(s, link, node);
+    return true;
+  }
+
+  void clear() {
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      Shard &s = shards_[i];
+      std::lock_guard<std::mutex> locker(s.mtx);
+      for (size_t b = 0; b <= s.mask; ++b) {
+        s.buckets[b].store(nullptr, std::memory_order_release);
+      }
+      for (Node *node : s.clock) {
+        EpochDomain::instance().retire(node);
+      }
+      s.clock.clear();
+      s.hand = 0;
+      s.usage.store(0, std::memory_order_relaxed);
+      s.count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * 以下统计不加锁，并发修改时只是近似值。
+   */
+  size_t size() const {
+    size_t n = 0;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      n += shards_[i].count.load(std::memory_order_relaxed);
+    }
+    return n;
+  }
+
+  size_t usage() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      bytes += shards_[i].usage.load(std::memory_order_relaxed);
+    }
+    return bytes;
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  size_t shard_count() const { return shard_mask_ + 1; }
+
+ private:
+  struct Node {
+    Node(const K &k, V &&v, uint64_t h, size_t c)
+        : key(k), value(std::move(v)), hash(h), charge(c) {}
+
+    const K key;
+    const V value;
+    const uint64_t hash;
+    const size_t charge;
+    std::atomic<Node *> next{nullptr};
+    // CLOCK 的引用位，命中时置 1，指针扫过时清 0
+    std::atomic<bool> referenced{false};
+    // 在 CLOCK 环中的下标，由分片锁保护
+    size_t clock_index = 0;
+  };
+
+  struct alignas(kCacheLineSize) Shard {
+    std::mutex mtx;
+    std::unique_ptr<std::atomic<Node *>[]> buckets;
+    size_t mask = 0;
+    // CLOCK 环，淘汰时把最后一个节点移到空出的位置
+    std::vector<Node *> clock;
+    size_t hand = 0;
+    size_t capacity = 0;
+    // 只在持锁时修改，用原子变量是为了不加锁读取统计值
+    std::atomic<size_t> usage{0};
+    std::atomic<size_t> count{0};
+  };
+
+  static size_t round_up(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  uint64_t hash_of(const K &key) const {
+    // 再混合一次，std::hash 对整数通常是恒等映射
+    uint64_t h = static_cast<uint64_t>(hash_(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // 桶用哈希的低位，分片用高位，两者互不相关
+  Shard &shard_for(uint64_t h) const {
+    return shards_[(h >> 40) & shard_mask_];
+  }
+
+  /**
+   * 持锁调用，返回指向 key 所在节点的链接；不存在时返回链表末尾的空链接。
+   */
+  std::atomic<Node *> *find_link(Shard &s, uint64_t h, const K &key) {
+    std::atomic<Node *> *link = &s.buckets[h & s.mask];
+    for (Node *p = link->load(std::memory_order_relaxed); p != nullptr;
+         p = link->load(std::memory_order_relaxed)) {
+      if (p->hash == h && eq_(p->key, key)) {
+        break;
+      }
+      link = &p->next;
+    }
+    return link;
+  }
+
+  /**
+   * 持锁调用。引用位为 1 的节点清零后放过，keep（刚插入的节点）不淘汰。
+   */
+  void evict_one(Shard &s, Node *keep) {
+    while (true) {
+      if (s.hand >= s.clock.size()) {
+        s.hand = 0;
+      }
+      Node *node = s.clock[s.hand];
+      if (node != keep && !node->referenced.load(std::memory_order_relaxed)) {
+        remove(s, find_link(s, node->hash, node->key), node);
+        return;
+      }
+      node->referenced.store(false, std::memory_order_relaxed);
+      ++s.hand;
+    }
+  }
+
+  void remove(Shard &s, std::atomic<Node *> *link, Node *node) {
+    link->store(node->next.load(std::memory_order_relaxed),
+                std::memory_order_release);
+    Node *last = s.clock.back();
+    last->clock_index = node->clock_index;
+    s.clock[node->clock_index] = last;
+    s.clock.pop_back();
+    s.usage.store(s.usage.load(std::memory_order_relaxed) - node->charge,
+                  std::memory_order_relaxed);
+    s.count.store(s.clock.size(), std::memory_order_relaxed);
+    EpochDomain::instance().retire(node);
+  }
+
+  std::unique_ptr<Shard[]> shards_;
+  size_t shard_mask_ = 0;
+  size_t capacity_ = 0;
+  Hash hash_;
+  KeyEqual eq_;
+};
+
+#endif /* DATA_STRUCTURE_SHARDED_CACHE_H */
@@ -0,0 +1,132 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "CircleQueue.h"
+#include "SpscQueue.h"
+
+void TestSpscQueue() {
+  SpscQueue<std::string> que(5);
+  std::cout << "que.capacity() = " << que.capacity() << std::endl;
+  int pushed = 0;
+  while (que.try_push(std::to_string(pushed))) {
+    ++pushed;
+  }
+  std::cout << "pushed until full: " << pushed << std::endl;
+  std::string value;
+  while (que.try_pop(value)) {
+    std::cout << value << " ";
+  }
+  std::cout << std::endl;
+
+  // 一个线程生产，一个线程消费，检查顺序和内容；第三个线程观察 size() 不越界
+  const long n = 1000000;
+  SpscQueue<long> ints(1024);
+  std::atomic<bool> done{false};
+  std::atomic<bool> size_ok{true};
+  std::thread observer([&ints, &done, &size_ok]() {
+    while (!done.load(std::memory_order_relaxed)) {
+      if (ints.size() > ints.capacity()) {
+        size_ok.store(false, std::memory_order_relaxed);
+      }
+    }
+  });
+  std::thread producer([&ints, n]() {
+    for (long i = 0; i < n; ++i) {
+      while (!ints.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  bool ordered = true;
+  for (long i = 0; i < n; ++i) {
+    long x;
+    while (!ints.try_pop(x)) {
+      std::this_thread::yield();
+    }
+    ordered = ordered && x == i;
+  }
+  producer.join();
+  done.store(true, std::memory_order_relaxed);
+  observer.join();
+  std::cout << "spsc order check: " << (ordered ? "ok" : "FAILED")
+            << ", size() from a third thread: "
+            << (size_ok.load() ? "ok" : "FAILED") << std::endl;
+}
+
+/**
+ * 用互斥量保护的 CircleQueue，作为对照。
+ */
+template <typename T>
+class LockedCircleQueue {
+ public:
+  explicit LockedCircleQueue(int capacity) : que_(capacity) {}
+
+  bool try_push(const T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    return que_.push(value);
+  }
+
+  bool try_pop(T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    if (que_.empty()) {
+      return false;
+    }
+    value = que_.front();
+    que_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mtx_;
+  CircleQueue<T> que_;
+};
+
+/**
+ * 一个生产者线程和一个消费者线程传递 n 个元素，返回每秒传递的元素数。
+ */
+template <typename Queue>
+double Throughput(Queue &que, long n) {
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&que, n]() {
+    for (long i = 0; i < n; ++i) {
+      while (!que.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  long sum = 0;
+  for (long i = 0; i < n; ++i) {
+    long x;
+    while (!que.try_pop(x)) {
+      std::this_thread::yield();
+    }
+    sum += x;
+  }
+  producer.join();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  if (sum != n * (n - 1) / 2) {
+    std::cout << "checksum mismatch" << std::endl;
+  }
+  return n / seconds;
+}
+
+void BenchmarkSpscQueue(long n) {
+  SpscQueue<long> spsc(1024);
+  LockedCircleQueue<long> locked(1024);
+  std::cout << "SpscQueue:              " << Throughput(spsc, n) << " ops/s"
+            << std::endl;
+  std::cout << "mutex + CircleQueue:    " << Throughput(locked, n) << " ops/s"
+            << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  TestSpscQueue();
+  long n = argc > 1 ? std::stol(argv[1]) : 10000000;
+  BenchmarkSpscQueue(n);
+}
@@ -0,0 +1,144 @@
+#ifndef DATA_STRUCTURE_SPSC_QUEUE_H
+#define DATA_STRUCTURE_SPSC_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * 单生产者单消费者的无锁循环队列，push 和 pop 都是 wait-free 的。
+ *
+ *  - 容量向上取整为 2 的幂，用位与代替取模；
+ *  - head_/tail_ 只增不减，分别由消费者和生产者独占写，位于不同的缓存行；
+ *  - 每一方缓存对方的下标，只有缓存显示队列满（空）时才重新读取对方的原子变量，
+ *    大部分操作不会访问另一个线程正在写的缓存行。
+ * 同一时刻只能有一个线程调用 push 系列函数、一个线程调用 pop 系列函数。
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  static constexpr size_t kCacheLine = 64;
+
+  explicit SpscQueue(size_t capacity) {
+    if (capacity == 0) {
+      throw std::length_error("cannot create a SpscQueue with capacity 0");
+    }
+    size_t n = 1;
+    while (n < capacity) {
+      n <<= 1;
+    }
+    mask_ = n - 1;
+    slots_.reset(new Slot[n]);
+  }
+
+  ~SpscQueue() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) {
+      slot(head)->~T();
+    }
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /**
+   * 生产者调用，队列满时返回 false。
+   */
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    new (slot(tail)) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T &value) { return try_emplace(value); }
+
+  bool try_push(T &&value) { return try_emplace(std::move(value)); }
+
+  /**
+   * 消费者调用，队列空时返回 nullptr。返回的指针在 pop 之前有效。
+   */
+  T *front() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return nullptr;
+      }
+    }
+    return slot(head);
+  }
+
+  /**
+   * 消费者调用，丢弃队首元素，队列不能为空（先用 front 检查）。
+   */
+  void pop() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    slot(head)->~T();
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /**
+   * 消费者调用，队列空时返回 false。
+   */
+  bool try_pop(T &value) {
+    T *p = front();
+    if (p == nullptr) {
+      return false;
+    }
+    value = std::move(*p);
+    pop();
+    return true;
+  }
+
+  /**
+   * 其他线程调用时只是一个近似值。先读 head_ 再读 tail_：先读 tail_ 的话，
+   * 两次读取之间消费者可能越过读到的 tail，相减会回绕成接近 2^64 的值。
+   * 先读 head_ 时结果不会为负，但两次读取之间生产者可能继续写入，所以再按容量截断。
+   */
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? std::min(tail - head, capacity()) : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  T *slot(size_t index) {
+    return std::launder(reinterpret_cast<T *>(slots_[index & mask_].storage));
+  }
+
+  // 只读成员
+  size_t mask_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+
+  // 消费者写的下标，以及消费者缓存的 tail_
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+
+  // 生产者写的下标，以及生产者缓存的 head_
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+};
+
+#endif /* DATA_STRUCTURE_SPSC_QUEUE_H */
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if __has_include(<asio.hpp>)
+#include <asio.hpp>
+#define TIMING_WHEEL_HAS_ASIO 1
+#else
+#define TIMING_WHEEL_HAS_ASIO 0
+#endif
+
+#include "TimingWheel.h"
+
+/**
+ * 各层的定时器都在到期的那个 tick 执行，取消的不执行，回调中可以添加和取消定时器。
+ */
+void TestTimingWheel() {
+  TimingWheel<> wheel;
+  std::mt19937_64 rng(7);
+  const uint64_t delays[] = {0,        1,          255,          256,
+                             16383,    16384,      (1u << 20) + 3, (1u << 26) + 5,
+                             (uint64_t(1) << 32) + 9};
+  int late = 0;
+  int fired = 0;
+  auto expect = [&](uint64_t tick) {
+    return [&, tick]() {
+      ++fired;
+      if (wheel.now() != tick) {
+        ++late;
+      }
+    };
+  };
+  for (uint64_t delay : delays) {
+    wheel.schedule(delay, expect(std::max<uint64_t>(delay, 1)));
+  }
+  std::vector<TimingWheel<>::TimerId> cancelled;
+  for (int i = 0; i < 10000; ++i) {
+    uint64_t delay = rng() % (1u << 22);
+    auto id = wheel.schedule(delay, expect(std::max<uint64_t>(delay, 1)));
+    if (i % 3 == 0) {
+      cancelled.push_back(id);
+    }
+  }
+  int cancel_ok = 0;
+  for (auto id : cancelled) {
+    cancel_ok += wheel.cancel(id);
+    cancel_ok -= wheel.cancel(id);
+  }
+
+  // 周期定时器：每 1000 tick 执行一次，执行 5 次后不再添加
+  int periodic = 0;
+  std::function<void()> tick_fn = [&]() {
+    if (++periodic < 5) {
+      wheel.schedule(1000, tick_fn);
+    }
+  };
+  wheel.schedule(1000, tick_fn);
+
+  // 同一个 tick 到期的两个定时器互相取消，执行顺序不确定，但只有先执行的那个会执行
+  TimingWheel<>::TimerId first = TimingWheel<>::kInvalidTimer;
+  TimingWheel<>::TimerId second = TimingWheel<>::kInvalidTimer;
+  int mutual = 0;
+  first = wheel.schedule_at(500, [&]() { mutual += 1 + wheel.cancel(second); });
+  second = wheel.schedule_at(500, [&]() { mutual += 1 + wheel.cancel(first); });
+
+  size_t total = wheel.advance_to(uint64_t(1) << 33);
+  std::cout << "timers fired = " << fired << " (expected "
+            << 9 + 10000 - cancelled.size() << "), late = " << late
+            << ", cancelled = " << cancel_ok << ", periodic = " << periodic
+            << ", mutual cancel = " << mutual << " (expected 2), advance returned "
+            << total << ", pending = " << wheel.size() << std::endl;
+}
+
+/**
+ * 回调抛出异常后，同一个 tick 中剩下的定时器仍在轮中：可以取消，下一次 advance 时执行。
+ */
+void TestTimingWheelThrowingCallback() {
+  TimingWheel<> wheel;
+  int ran = 0;
+  std::vector<TimingWheel<>::TimerId> ids;
+  for (int i = 0; i < 4; ++i) {
+    ids.push_back(wheel.schedule_at(10, [&ran]() { ++ran; }));
+  }
+  wheel.schedule_at(10, []() { throw std::runtime_error("timer"); });
+  wheel.schedule_at(15, [&ran]() { ++ran; });
+  bool caught = false;
+  try {
+    wheel.advance_to(20);
+  } catch (const std::runtime_error &) {
+    caught = true;
+  }
+  uint64_t stopped_at = wheel.now();
+  size_t pending = wheel.size();
+  // 还没执行的定时器中取消一个
+  int cancelled = 0;
+  for (auto id : ids) {
+    if (wheel.cancel(id)) {
+      ++cancelled;
+      break;
+    }
+  }
+  wheel.advance_to(20);
+  std::cout << "throwing callback: caught = " << caught
+            << ", stopped at = " << stopped_at
+            << ", pending after throw = " << pending
+            << ", ran + cancelled = " << ran + cancelled << " (expected 5)"
+            << ", size = " << wheel.size() << std::endl;
+}
+
+/**
+ * 二叉堆实现的定时器，取消时只做标记，弹出时跳过，这是最常见的写法。
+ */
+class TimerHeap {
+ public:
+  using TimerId = uint64_t;
+
+  TimerId schedule(uint64_t delay, std::function<void()> callback) {
+    TimerId id = callbacks_.size();
+    callbacks_.push_back(std::move(callback));
+    heap_.push({now_ + std::max<uint64_t>(delay, 1), id});
+    return id;
+  }
+
+  bool cancel(TimerId id) {
+    if (id >= callbacks_.size() || !callbacks_[id]) {
+      return false;
+    }
+    callbacks_[id] = nullptr;
+    return true;
+  }
+
+  size_t advance_to(uint64_t tick) {
+    size_t fired = 0;
+    while (!heap_.empty() && heap_.top().expires <= tick) {
+      Entry e = heap_.top();
+      heap_.pop();
+      if (callbacks_[e.id]) {
+        now_ = e.expires;
+        auto callback = std::move(callbacks_[e.id]);
+        callbacks_[e.id] = nullptr;
+        callback();
+        ++fired;
+      }
+    }
+    now_ = tick;
+    return fired;
+  }
+
+ private:
+  struct Entry {
+    uint64_t expires;
+    TimerId id;
+    bool operator>(const Entry &other) const {
+      return expires > other.expires;
+    }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+  std::vector<std::function<void()>> callbacks_;
+  uint64_t now_ = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string benchmark;
+  std::string timer;
+  size_t timers = 0;
+  double ns_per_op = 0;
+};
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         ops;
+}
+
+/**
+ * schedule：添加 n 个到期时间随机的定时器；cancel：随机取消一半；
+ * expire：推进到全部到期，按执行的定时器计，包含空转的 tick。
+ */
+template <class Timers>
+std::vector<Result> BenchTimers(const std::string &name,
+                                const std::vector<uint64_t> &delays,
+                                const std::vector<size_t> &order) {
+  std::vector<Result> results;
+  size_t n = delays.size();
+  uint64_t counter = 0;
+  Timers timers;
+  std::vector<uint64_t> ids(n);
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    ids[i] = timers.schedule(delays[i], [&counter]() { ++counter; });
+  }
+  results.push_back({"schedule", name, n, ns_per_op(start, n)});
+
+  start = Clock::now();
+  for (size_t i = 0; i < n / 2; ++i) {
+    timers.cancel(ids[order[i]]);
+  }
+  results.push_back({"cancel", name, n, ns_per_op(start, n / 2)});
+
+  start = Clock::now();
+  uint64_t last = *std::max_element(delays.begin(), delays.end());
+  size_t fired = timers.advance_to(last);
+  results.push_back({"expire", name, n, ns_per_op(start, fired)});
+  if (fired != counter || fired != n - n / 2) {
+    std::cerr << name << ": fired " << fired << " timers, expected "
+              << n - n / 2 << std::endl;
+  }
+  return results;
+}
+
+#if TIMING_WHEEL_HAS_ASIO
+/**
+ * 每个事件一个 asio::steady_timer，1 tick 记为 1 纳秒，
+ * 到期时间都在 1ms 以内，expire 阶段基本不需要真的等待。
+ */
+std::vector<Result> BenchAsio(const std::vector<uint64_t> &delays,
+                              const std::vector<size_t> &order) {
+  std::vector<Result> results;
+  size_t n = delays.size();
+  size_t fired = 0;
+  asio::io_context io;
+  std::vector<std::unique_ptr<asio::steady_timer>> timers(n);
+
+  auto start = Clock::now();
+  auto base = asio::steady_timer::clock_type::now();
+  for (size_t i = 0; i < n; ++i) {
+    timers[i] = std::make_unique<asio::steady_timer>(
+        io, base + std::chrono::nanoseconds(delays[i] % 1000000));
+    timers[i]->async_wait([&fired](const std::error_code &ec) {
+      if (!ec) {
+        ++fired;
+      }
+    });
+  }
+  results.push_back({"schedule", "asio", n, ns_per_op(start, n)});
+
+  start = Clock::now();
+  for (size_t i = 0; i < n / 2; ++i) {
+    timers[order[i]]->cancel();
+  }
+  results.push_back({"cancel", "asio", n, ns_per_op(start, n / 2)});
+
+  start = Clock::now();
+  io.run();
+  results.push_back({"expire", "asio", n, ns_per_op(start, fired)});
+  return results;
+}
+#endif
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"timer\":\""
+              << r.timer << "\",\"timers\":" << r.timers
+              << ",\"ns_per_op\":" << r.ns_per_op << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.timer << "," << r.timers << ","
+              << r.ns_per_op << std::endl;
+  }
+}
+
+/**
+ *   ./TimingWheel [--json] [--max-timers=N]
+ * 定时器数从 1K 按 10 倍增加到 max-timers（默认 1M），到期时间在 2^20 tick 内均匀分布。
+ * 找得到 asio 头文件时同时比较每个事件一个 asio::steady_timer 的做法。
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  size_t max_timers = 1000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-timers=", 0) == 0) {
+      max_timers = std::max<size_t>(1000, std::stoull(arg.substr(13)));
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--json] [--max-timers=N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestTimingWheel();
+    TestTimingWheelThrowingCallback();
+    std::cout << "benchmark,timer,timers,ns_per_op" << std::endl;
+  }
+  std::mt19937_64 rng(2024);
+  for (size_t n = 1000; n <= max_timers; n *= 10) {
+    std::vector<uint64_t> delays(n);
+    for (auto &delay : delays) {
+      delay = 1 + rng() % (1u << 20);
+    }
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) {
+      order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    for (const auto &r : BenchTimers<TimingWheel<>>("TimingWheel", delays,
+                                                    order)) {
+      print(r, json);
+    }
+    for (const auto &r : BenchTimers<TimerHeap>("priority_queue", delays,
+                                                order)) {
+      print(r, json);
+    }
+#if TIMING_WHEEL_HAS_ASIO
+    for (const auto &r : BenchAsio(delays, order)) {
+      print(r, json);
+    }
+#endif
+  }
+}
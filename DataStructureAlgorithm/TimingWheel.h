@@ -0,0 +1,282 @@
+#ifndef DATA_STRUCTURE_TIMING_WHEEL_H
+#define DATA_STRUCTURE_TIMING_WHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * 分层时间轮（与 Linux 早期内核定时器的结构相同）。
+ *
+ * 时间以 tick 为单位，由调用者通过 advance 推进。第 0 层有 256 个槽，每槽 1 tick；
+ * 第 1~4 层各有 64 个槽，每槽覆盖下一层一整圈，共能表示 2^32 tick 以内的到期时间，
+ * 更远的定时器先放在最高层，级联时重新计算位置。
+ * 第 0 层转完一圈时把上一层当前槽中的定时器重新分配到下层（级联），
+ * 每个定时器最多被级联 4 次。
+ * 添加、取消都是 O(1)：定时器节点放在数组里，用下标串成双向链表，
+ * 取消时直接从所在的槽中摘下；节点复用时代数加一，旧的 TimerId 自动失效。
+ * 不是线程安全的，通常由一个事件循环线程独占。
+ */
+template <typename Callback = std::function<void()>>
+class TimingWheel {
+ public:
+  /**
+   * 高 32 位是节点的代数，低 32 位是节点下标，0 不是合法的 id。
+   */
+  using TimerId = uint64_t;
+
+  static constexpr TimerId kInvalidTimer = 0;
+
+  TimingWheel() { heads_.fill(kNil); }
+
+  /**
+   * 在 now() + delay 时到期；delay 为 0 时在下一次 advance 时到期。
+   */
+  TimerId schedule(uint64_t delay, Callback callback) {
+    return schedule_at(now() + delay, std::move(callback));
+  }
+
+  /**
+   * 在第 tick 个 tick 到期，早于当前时间的在下一次 advance 时到期。
+   */
+  TimerId schedule_at(uint64_t tick, Callback callback) {
+    uint32_t index = allocate();
+    Node &node = nodes_[index];
+    node.callback = std::move(callback);
+    node.expires = tick < jiffies_ ? jiffies_ : tick;
+    link(index, bucket_of(node.expires));
+    ++size_;
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+  }
+
+  /**
+   * 定时器已经到期、已经取消或 id 不合法时返回 false。
+   * 可以在回调中调用，包括取消同一个 tick 中还没有执行的定时器。
+   */
+  bool cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes_.size() || nodes_[index].generation != generation ||
+        nodes_[index].bucket == kNil) {
+      return false;
+    }
+    unlink(index);
+    release(index);
+    --size_;
+    return true;
+  }
+
+  /**
+   * 推进 ticks 个 tick，执行期间到期的回调，返回执行的个数。
+   */
+  size_t advance(uint64_t ticks = 1) { return advance_to(now() + ticks); }
+
+  /**
+   * 推进到第 tick 个 tick（不会后退）。回调中 now() 等于定时器的到期时间，
+   * 回调里可以添加和取消定时器。
+   * 回调抛出异常时推进停在当前 tick，异常传给调用者；同一个 tick 中还没有执行的定时器
+   * 留在轮中，下一次 advance 时执行（此时 now() 晚于它们的到期时间），仍然可以取消。
+   */
+  size_t advance_to(uint64_t tick) {
+    size_t fired = 0;
+    while (jiffies_ <= tick) {
+      if (size_ == 0) {
+        jiffies_ = tick + 1;
+        break;
+      }
+      // 第 0 层没有定时器时直接跳到这一圈的末尾，中间的 tick 没有事可做
+      if (level0_size_ == 0 && (jiffies_ & kMask0) != 0) {
+        uint64_t next_round = (jiffies_ | kMask0) + 1;
+        jiffies_ = next_round <= tick ? next_round : tick + 1;
+        continue;
+      }
+      fired += run_tick();
+    }
+    return fired;
+  }
+
+  /**
+   * 最近一次处理过的 tick，初始为 0。
+   */
+  uint64_t now() const { return jiffies_ - 1; }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * 预先分配 n 个定时器节点。
+   */
+  void reserve(size_t n) { nodes_.reserve(n); }
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr int kBits0 = 8;
+  static constexpr int kBits = 6;
+  static constexpr int kLevels = 5;
+  static constexpr uint32_t kSlots0 = 1u << kBits0;
+  static constexpr uint32_t kSlots = 1u << kBits;
+  static constexpr uint64_t kMask0 = kSlots0 - 1;
+  static constexpr uint64_t kMask = kSlots - 1;
+  static constexpr uint64_t kMaxDelta =
+      (uint64_t(1) << (kBits0 + kBits * (kLevels - 1))) - 1;
+  // 正在执行的那一槽定时器先挪到这里，回调中取消它们时同样只需摘链
+  static constexpr uint32_t kFiring = kSlots0 + kSlots * (kLevels - 1);
+
+  struct Node {
+    Callback callback;
+    uint64_t expires = 0;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    // 所在的槽，kNil 表示空闲
+    uint32_t bucket = kNil;
+    uint32_t generation = 1;
+  };
+
+  uint32_t allocate() {
+    if (free_ != kNil) {
+      uint32_t index = free_;
+      free_ = nodes_[index].next;
+      return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  void release(uint32_t index) {
+    Node &node = nodes_[index];
+    node.callback = Callback();
+    node.bucket = kNil;
+    if (++node.generation == 0) {
+      node.generation = 1;
+    }
+    node.next = free_;
+    free_ = index;
+  }
+
+  /**
+   * expires 不早于 jiffies_。
+   */
+  uint32_t bucket_of(uint64_t expires) const {
+    uint64_t delta = expires - jiffies_;
+    if (delta < kSlots0) {
+      return static_cast<uint32_t>(expires & kMask0);
+    }
+    if (delta > kMaxDelta) {
+      expires = jiffies_ + kMaxDelta;
+      delta = kMaxDelta;
+    }
+    int shift = kBits0;
+    uint32_t base = kSlots0;
+    while (delta >= (uint64_t(1) << (shift + kBits))) {
+      shift += kBits;
+      base += kSlots;
+    }
+    return base + static_cast<uint32_t>((expires >> shift) & kMask);
+  }
+
+  void link(uint32_t index, uint32_t bucket) {
+    Node &node = nodes_[index];
+    node.bucket = bucket;
+    node.prev = kNil;
+    node.next = heads_[bucket];
+    if (node.next != kNil) {
+      nodes_[node.next].prev = index;
+    }
+    heads_[bucket] = index;
+    if (bucket < kSlots0) {
+      ++level0_size_;
+    }
+  }
+
+  void unlink(uint32_t index) {
+    Node &node = nodes_[index];
+    if (node.prev != kNil) {
+      nodes_[node.prev].next = node.next;
+    } else {
+      heads_[node.bucket] = node.next;
+    }
+    if (node.next != kNil) {
+      nodes_[node.next].prev = node.prev;
+    }
+    if (node.bucket < kSlots0) {
+      --level0_size_;
+    }
+  }
+
+  /**
+   * 把第 level 层当前槽中的定时器重新分配到下层，返回该槽的下标。
+   */
+  uint32_t cascade(int level) {
+    int shift = kBits0 + kBits * (level - 1);
+    uint32_t slot = static_cast<uint32_t>((jiffies_ >> shift) & kMask);
+    uint32_t bucket = kSlots0 + kSlots * (level - 1) + slot;
+    uint32_t index = heads_[bucket];
+    heads_[bucket] = kNil;
+    while (index != kNil) {
+      uint32_t next = nodes_[index].next;
+      link(index, bucket_of(nodes_[index].expires));
+      index = next;
+    }
+    return slot;
+  }
+
+  size_t run_tick() {
+    uint32_t slot = static_cast<uint32_t>(jiffies_ & kMask0);
+    if (slot == 0) {
+      for (int level = 1; level < kLevels && cascade(level) == 0; ++level) {
+      }
+    }
+    ++jiffies_;
+
+    uint32_t index = heads_[slot];
+    heads_[slot] = kNil;
+    heads_[kFiring] = index;
+    for (; index != kNil; index = nodes_[index].next) {
+      nodes_[index].bucket = kFiring;
+      --level0_size_;
+    }
+
+    size_t fired = 0;
+    while ((index = heads_[kFiring]) != kNil) {
+      unlink(index);
+      // 回调可能添加定时器使 nodes_ 扩容，先把回调移出来并释放节点
+      Callback callback = std::move(nodes_[index].callback);
+      release(index);
+      --size_;
+      ++fired;
+      try {
+        callback();
+      } catch (...) {
+        requeue_firing();
+        throw;
+      }
+    }
+    return fired;
+  }
+
+  /**
+   * 把还没有执行的定时器放回第 0 层下一个 tick 的槽。
+   */
+  void requeue_firing() {
+    uint32_t bucket = static_cast<uint32_t>(jiffies_ & kMask0);
+    uint32_t index;
+    while ((index = heads_[kFiring]) != kNil) {
+      unlink(index);
+      link(index, bucket);
+    }
+  }
+
+  std::vector<Node> nodes_;
+  std::array<uint32_t, kFiring + 1> heads_;
+  uint32_t free_ = kNil;
+  // 下一个要处理的 tick
+  uint64_t jiffies_ = 1;
+  size_t size_ = 0;
+  size_t level0_size_ = 0;
+};
+
+#endif /* DATA_STRUCTURE_TIMING_WHEEL_H */
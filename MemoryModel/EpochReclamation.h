@@ -0,0 +1,233 @@
+#ifndef MEMORY_MODEL_EPOCH_RECLAMATION_H
+#define MEMORY_MODEL_EPOCH_RECLAMATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "SpinLock.h"
+
+/**
+ * 基于纪元（epoch）的内存回收，用于无锁数据结构中被摘下的节点。
+ *
+ * 线程访问共享数据前 pin 住当前的全局纪元，访问结束后 unpin。
+ * 节点从数据结构中摘下后调用 retire，并记下当时的全局纪元 e；
+ * 只有所有处于 pin 状态的线程都看到了当前纪元，全局纪元才能前进，
+ * 所以全局纪元到达 e + 2 时，不可能还有线程持有该节点，可以释放。
+ * pin/unpin 只写本线程的记录，代价是一次 seq_cst 栅栏；
+ * 缺点是一个线程长时间 pin 住会让所有线程都无法回收。
+ */
+class EpochDomain {
+ public:
+  /**
+   * 进程内唯一的实例，故意不析构，线程退出时仍然可以访问。
+   */
+  static EpochDomain &instance() {
+    static EpochDomain *domain = new EpochDomain();
+    return *domain;
+  }
+
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  /**
+   * 可以嵌套，只有最外层生效。
+   */
+  void pin() {
+    Record *record = local().record;
+    if (record->depth++ == 0) {
+      uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+      // release：推进纪元的线程读到这里时，上一次临界区内的读都已完成
+      record->state.store((epoch << 1) | 1, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  void unpin() {
+    Record *record = local().record;
+    if (--record->depth == 0) {
+      record->state.store(0, std::memory_order_release);
+    }
+  }
+
+  template <typename T>
+  void retire(T *p) {
+    retire(p, [](void *q) { delete static_cast<T *>(q); });
+  }
+
+  /**
+   * p 必须已经从数据结构中摘下，之后不会再被新的读者看到。
+   */
+  void retire(void *p, void (*deleter)(void *)) {
+    ThreadState &state = local();
+    state.retired.push_back({p, deleter, epoch_.load(std::memory_order_acquire)});
+    if (state.retired.size() >= state.next_collect) {
+      collect(state);
+    }
+  }
+
+  /**
+   * 尝试推进纪元并释放本线程（以及已退出线程）中可以释放的节点。
+   */
+  void collect() { collect(local()); }
+
+  uint64_t epoch() const { return epoch_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr size_t kCollectThreshold = 64;
+
+  struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+    uint64_t epoch;
+  };
+
+  // 每个线程一条，线程退出后可以被新线程复用
+  struct alignas(kCacheLineSize) Record {
+    // (纪元 << 1) | 1 表示 pin 住，0 表示没有
+    std::atomic<uint64_t> state{0};
+    std::atomic<bool> in_use{true};
+    Record *next = nullptr;
+    int depth = 0;
+  };
+
+  struct ThreadState {
+    Record *record = nullptr;
+    std::vector<Retired> retired;
+    // 有线程长时间 pin 住时节点释放不掉，按剩余数量加倍下一次回收的阈值，避免反复扫描
+    size_t next_collect = kCollectThreshold;
+
+    ~ThreadState() { EpochDomain::instance().release(*this); }
+  };
+
+  EpochDomain() = default;
+
+  ThreadState &local() {
+    thread_local ThreadState state;
+    if (state.record == nullptr) {
+      state.record = acquire_record();
+    }
+    return state;
+  }
+
+  Record *acquire_record() {
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      bool expected = false;
+      if (!r->in_use.load(std::memory_order_relaxed) &&
+          r->in_use.compare_exchange_strong(expected, true,
+                                            std::memory_order_acquire)) {
+        return r;
+      }
+    }
+    Record *r = new Record();
+    Record *head = records_.load(std::memory_order_relaxed);
+    do {
+      r->next = head;
+    } while (!records_.compare_exchange_weak(head, r, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    return r;
+  }
+
+  /**
+   * 线程退出：释放能释放的节点，剩下的交给其他线程。
+   */
+  void release(ThreadState &state) {
+    if (state.record == nullptr) {
+      return;
+    }
+    collect(state);
+    if (!state.retired.empty()) {
+      std::lock_guard<std::mutex> locker(orphans_mtx_);
+      orphans_.insert(orphans_.end(), state.retired.begin(),
+                      state.retired.end());
+      has_orphans_.store(true, std::memory_order_release);
+    }
+    state.record->state.store(0, std::memory_order_relaxed);
+    state.record->in_use.store(false, std::memory_order_release);
+    state.record = nullptr;
+  }
+
+  /**
+   * 所有 pin 住的线程都处于当前纪元时，把全局纪元加一。
+   */
+  void try_advance() {
+    uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      uint64_t state = r->state.load(std::memory_order_acquire);
+      if ((state & 1) && (state >> 1) != epoch) {
+        return;
+      }
+    }
+    epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel,
+                                   std::memory_order_relaxed);
+  }
+
+  void collect(ThreadState &state) {
+    try_advance();
+    uint64_t epoch = epoch_.load(std::memory_order_acquire);
+    free_expired(state.retired, epoch);
+    state.next_collect = std::max(kCollectThreshold, 2 * state.retired.size());
+    if (has_orphans_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> locker(orphans_mtx_);
+      free_expired(orphans_, epoch);
+      has_orphans_.store(!orphans_.empty(), std::memory_order_relaxed);
+    }
+  }
+
+  static void free_expired(std::vector<Retired> &retired, uint64_t epoch) {
+    auto keep = std::partition(retired.begin(), retired.end(),
+                               [epoch](const Retired &r) {
+                                 return r.epoch + 2 > epoch;
+                               });
+    for (auto it = keep; it != retired.end(); ++it) {
+      it->deleter(it->ptr);
+    }
+    retired.erase(keep, retired.end());
+  }
+
+  alignas(kCacheLineSize) std::atomic<uint64_t> epoch_{0};
+  alignas(kCacheLineSize) std::atomic<Record *> records_{nullptr};
+  std::mutex orphans_mtx_;
+  std::vector<Retired> orphans_;
+  std::atomic<bool> has_orphans_{false};
+};
+
+/**
+ * 作用域内 pin 住当前纪元。
+ */
+class EpochGuard {
+ public:
+  EpochGuard() { EpochDomain::instance().pin(); }
+  ~EpochGuard() { EpochDomain::instance().unpin(); }
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+/**
+ * 供无锁数据结构使用的回收策略，与 HazardReclaimer 接口相同。
+ * pin 住期间读到的指针都是安全的，protect 只是普通的 acquire 读。
+ */
+struct EpochReclaimer {
+  class Guard {
+   public:
+    template <typename T>
+    T *protect(int /*slot*/, const std::atomic<T *> &src) {
+      return src.load(std::memory_order_acquire);
+    }
+
+   private:
+    EpochGuard guard_;
+  };
+
+  template <typename T>
+  static void retire(T *p) {
+    EpochDomain::instance().retire(p);
+  }
+};
+
+#endif /* MEMORY_MODEL_EPOCH_RECLAMATION_H */
@@ -0,0 +1,226 @@
+#ifndef MEMORY_MODEL_HAZARD_POINTER_H
+#define MEMORY_MODEL_HAZARD_POINTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "SpinLock.h"
+
+/**
+ * 风险指针（hazard pointer）内存回收。
+ *
+ * 读者把将要访问的节点地址发布到自己的风险指针上，再确认节点仍在数据结构中；
+ * 回收时扫描所有风险指针，只释放没有被任何线程发布的节点。
+ * 与纪元回收相比，每次访问节点都要发布一次（一次 seq_cst 栅栏），读路径更贵，
+ * 但未释放的节点数有上界，一个停住的线程最多挡住它发布的几个节点。
+ */
+class HazardDomain {
+ public:
+  struct alignas(kCacheLineSize) Record {
+    std::atomic<const void *> ptr{nullptr};
+    std::atomic<bool> in_use{true};
+    Record *next = nullptr;
+  };
+
+  /**
+   * 进程内唯一的实例，故意不析构，线程退出时仍然可以访问。
+   */
+  static HazardDomain &instance() {
+    static HazardDomain *domain = new HazardDomain();
+    return *domain;
+  }
+
+  HazardDomain(const HazardDomain &) = delete;
+  HazardDomain &operator=(const HazardDomain &) = delete;
+
+  /**
+   * 优先复用本线程缓存的记录，其次是其他线程释放的记录，最后才分配新的。
+   */
+  Record *acquire() {
+    ThreadState &state = local();
+    if (!state.cache.empty()) {
+      Record *r = state.cache.back();
+      state.cache.pop_back();
+      return r;
+    }
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      bool expected = false;
+      if (!r->in_use.load(std::memory_order_relaxed) &&
+          r->in_use.compare_exchange_strong(expected, true,
+                                            std::memory_order_acquire)) {
+        return r;
+      }
+    }
+    Record *r = new Record();
+    Record *head = records_.load(std::memory_order_relaxed);
+    do {
+      r->next = head;
+    } while (!records_.compare_exchange_weak(head, r, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    num_records_.fetch_add(1, std::memory_order_relaxed);
+    return r;
+  }
+
+  void release(Record *r) {
+    r->ptr.store(nullptr, std::memory_order_release);
+    local().cache.push_back(r);
+  }
+
+  template <typename T>
+  void retire(T *p) {
+    retire(p, [](void *q) { delete static_cast<T *>(q); });
+  }
+
+  /**
+   * p 必须已经从数据结构中摘下。待回收的节点数超过风险指针数的两倍时扫描一次，
+   * 每次扫描至少能释放一半。
+   */
+  void retire(void *p, void (*deleter)(void *)) {
+    ThreadState &state = local();
+    state.retired.push_back({p, deleter});
+    size_t threshold = std::max<size_t>(
+        kMinReclaimThreshold, 2 * num_records_.load(std::memory_order_relaxed));
+    if (state.retired.size() >= threshold) {
+      reclaim(state);
+    }
+  }
+
+  /**
+   * 释放本线程（以及已退出线程）中没有被保护的节点。
+   */
+  void reclaim() { reclaim(local()); }
+
+ private:
+  static constexpr size_t kMinReclaimThreshold = 64;
+
+  struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+  };
+
+  struct ThreadState {
+    std::vector<Record *> cache;
+    std::vector<Retired> retired;
+
+    ~ThreadState() { HazardDomain::instance().release(*this); }
+  };
+
+  HazardDomain() = default;
+
+  ThreadState &local() {
+    thread_local ThreadState state;
+    return state;
+  }
+
+  void release(ThreadState &state) {
+    reclaim(state);
+    if (!state.retired.empty()) {
+      std::lock_guard<std::mutex> locker(orphans_mtx_);
+      orphans_.insert(orphans_.end(), state.retired.begin(),
+                      state.retired.end());
+      has_orphans_.store(true, std::memory_order_release);
+      state.retired.clear();
+    }
+    for (Record *r : state.cache) {
+      r->in_use.store(false, std::memory_order_release);
+    }
+    state.cache.clear();
+  }
+
+  void reclaim(ThreadState &state) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<const void *> hazards;
+    for (Record *r = records_.load(std::memory_order_acquire); r != nullptr;
+         r = r->next) {
+      const void *p = r->ptr.load(std::memory_order_acquire);
+      if (p != nullptr) {
+        hazards.push_back(p);
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    free_unprotected(state.retired, hazards);
+    if (has_orphans_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> locker(orphans_mtx_);
+      free_unprotected(orphans_, hazards);
+      has_orphans_.store(!orphans_.empty(), std::memory_order_relaxed);
+    }
+  }
+
+  static void free_unprotected(std::vector<Retired> &retired,
+                               const std::vector<const void *> &hazards) {
+    auto keep = std::partition(
+        retired.begin(), retired.end(), [&hazards](const Retired &r) {
+          return std::binary_search(hazards.begin(), hazards.end(), r.ptr);
+        });
+    for (auto it = keep; it != retired.end(); ++it) {
+      it->deleter(it->ptr);
+    }
+    retired.erase(keep, retired.end());
+  }
+
+  alignas(kCacheLineSize) std::atomic<Record *> records_{nullptr};
+  std::atomic<size_t> num_records_{0};
+  std::mutex orphans_mtx_;
+  std::vector<Retired> orphans_;
+  std::atomic<bool> has_orphans_{false};
+};
+
+/**
+ * 占用一个风险指针，析构时清空并归还。
+ */
+class HazardPointer {
+ public:
+  HazardPointer() : record_(HazardDomain::instance().acquire()) {}
+  ~HazardPointer() { HazardDomain::instance().release(record_); }
+  HazardPointer(const HazardPointer &) = delete;
+  HazardPointer &operator=(const HazardPointer &) = delete;
+
+  /**
+   * 读取 src 并发布，直到发布后 src 没有变化，返回的指针在 reset 之前不会被释放。
+   */
+  template <typename T>
+  T *protect(const std::atomic<T *> &src) {
+    T *p = src.load(std::memory_order_relaxed);
+    while (true) {
+      record_->ptr.store(p, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      T *q = src.load(std::memory_order_acquire);
+      if (p == q) {
+        return p;
+      }
+      p = q;
+    }
+  }
+
+  void reset() { record_->ptr.store(nullptr, std::memory_order_release); }
+
+ private:
+  HazardDomain::Record *record_;
+};
+
+/**
+ * 供无锁数据结构使用的回收策略，每个 Guard 提供两个风险指针（槽位 0 和 1）。
+ */
+struct HazardReclaimer {
+  class Guard {
+   public:
+    template <typename T>
+    T *protect(int slot, const std::atomic<T *> &src) {
+      return hazards_[slot].protect(src);
+    }
+
+   private:
+    HazardPointer hazards_[2];
+  };
+
+  template <typename T>
+  static void retire(T *p) {
+    HazardDomain::instance().retire(p);
+  }
+};
+
+#endif /* MEMORY_MODEL_HAZARD_POINTER_H */
@@ -0,0 +1,130 @@
+#ifndef MEMORY_MODEL_LOCK_FREE_QUEUE_H
+#define MEMORY_MODEL_LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "EpochReclamation.h"
+
+/**
+ * Michael-Scott 无锁队列（无界）。
+ *
+ * 链表头部始终是一个哑节点，head_ 指向它，真正的队首是哑节点的下一个节点；
+ * 出队时 head_ 后移一位，被跳过的旧哑节点交给 Reclaimer 延迟释放，
+ * 新的哑节点就是刚出队的元素所在的节点（值已经移走）。
+ * 入队在 tail_ 之后链接新节点，tail_ 落后时任何线程都可以帮忙推进。
+ */
+template <typename T, class Reclaimer = EpochReclaimer>
+class LockFreeQueue {
+ public:
+  LockFreeQueue() {
+    Node *dummy = new Node();
+    head_.store(dummy, std::memory_order_relaxed);
+    tail_.store(dummy, std::memory_order_relaxed);
+  }
+
+  LockFreeQueue(const LockFreeQueue &) = delete;
+  LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+  /**
+   * 不能与其他线程的操作并发。
+   */
+  ~LockFreeQueue() {
+    Node *node = head_.load(std::memory_order_relaxed);
+    // 哑节点没有值
+    Node *next = node->next.load(std::memory_order_relaxed);
+    delete node;
+    for (node = next; node != nullptr; node = next) {
+      next = node->next.load(std::memory_order_relaxed);
+      node->value()->~T();
+      delete node;
+    }
+  }
+
+  template <typename... Args>
+  void emplace(Args &&...args) {
+    Node *node = new Node();
+    new (node->storage) T(std::forward<Args>(args)...);
+    typename Reclaimer::Guard guard;
+    while (true) {
+      Node *tail = guard.protect(0, tail_);
+      Node *next = tail->next.load(std::memory_order_acquire);
+      if (tail != tail_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      if (next != nullptr) {
+        // tail_ 落后了，帮忙推进
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                    std::memory_order_relaxed);
+        continue;
+      }
+      if (tail->next.compare_exchange_weak(next, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        tail_.compare_exchange_strong(tail, node, std::memory_order_release,
+                                      std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  void push(const T &value) { emplace(value); }
+
+  void push(T &&value) { emplace(std::move(value)); }
+
+  /**
+   * 队列空时返回 false。
+   */
+  bool pop(T &value) {
+    typename Reclaimer::Guard guard;
+    while (true) {
+      Node *head = guard.protect(0, head_);
+      Node *next = guard.protect(1, head->next);
+      if (head != head_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      if (next == nullptr) {
+        return false;
+      }
+      Node *tail = tail_.load(std::memory_order_acquire);
+      if (head == tail) {
+        tail_.compare_exchange_weak(tail, next, std::memory_order_release,
+                                    std::memory_order_relaxed);
+        continue;
+      }
+      // release：之后读到 head_ == next 的线程与这里同步，能看到 next 节点的初始化
+      if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel,
+                                      std::memory_order_relaxed)) {
+        // next 成为新的哑节点，只有赢得 CAS 的线程会访问它的值
+        T *p = next->value();
+        value = std::move(*p);
+        p->~T();
+        Reclaimer::retire(head);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * 并发访问时只是近似值。
+   */
+  bool empty() {
+    typename Reclaimer::Guard guard;
+    Node *head = guard.protect(0, head_);
+    return head->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  struct Node {
+    T *value() { return std::launder(reinterpret_cast<T *>(storage)); }
+
+    std::atomic<Node *> next{nullptr};
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  alignas(kCacheLineSize) std::atomic<Node *> head_;
+  alignas(kCacheLineSize) std::atomic<Node *> tail_;
+};
+
+#endif /* MEMORY_MODEL_LOCK_FREE_QUEUE_H */
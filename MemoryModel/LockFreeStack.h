@@ -0,0 +1,86 @@
+#ifndef MEMORY_MODEL_LOCK_FREE_STACK_H
+#define MEMORY_MODEL_LOCK_FREE_STACK_H
+
+#include <atomic>
+#include <utility>
+
+#include "EpochReclamation.h"
+
+/**
+ * Treiber 无锁栈。
+ *
+ * 弹出的节点交给 Reclaimer（EpochReclaimer 或 HazardReclaimer）延迟释放，
+ * 其他线程正在读的节点不会被释放或复用，因此没有 ABA 问题，T 也可以是任意可移动的类型。
+ */
+template <typename T, class Reclaimer = EpochReclaimer>
+class LockFreeStack {
+ public:
+  LockFreeStack() = default;
+  LockFreeStack(const LockFreeStack &) = delete;
+  LockFreeStack &operator=(const LockFreeStack &) = delete;
+
+  /**
+   * 不能与其他线程的操作并发。
+   */
+  ~LockFreeStack() {
+    Node *node = head_.load(std::memory_order_relaxed);
+    while (node != nullptr) {
+      Node *next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  template <typename... Args>
+  void emplace(Args &&...args) {
+    Node *node = new Node(std::forward<Args>(args)...);
+    node->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  void push(const T &value) { emplace(value); }
+
+  void push(T &&value) { emplace(std::move(value)); }
+
+  /**
+   * 栈空时返回 false。
+   */
+  bool pop(T &value) {
+    typename Reclaimer::Guard guard;
+    while (true) {
+      Node *node = guard.protect(0, head_);
+      if (node == nullptr) {
+        return false;
+      }
+      // node 受保护，读 next 是安全的；next 在入栈后不再修改
+      if (head_.compare_exchange_weak(node, node->next,
+                                      std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+        value = std::move(node->value);
+        Reclaimer::retire(node);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * 并发访问时只是近似值。
+   */
+  bool empty() const { return head_.load(std::memory_order_relaxed) == nullptr; }
+
+ private:
+  struct Node {
+    template <typename... Args>
+    explicit Node(Args &&...args) : value(std::forward<Args>(args)...) {}
+
+    T value;
+    Node *next = nullptr;
+  };
+
+  alignas(kCacheLineSize) std::atomic<Node *> head_{nullptr};
+};
+
+#endif /* MEMORY_MODEL_LOCK_FREE_STACK_H */
@@ -0,0 +1,123 @@
+#ifndef MEMORY_MODEL_RW_LOCK_H
+#define MEMORY_MODEL_RW_LOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "SpinLock.h"
+
+/**
+ * 读者计数分散在多个缓存行上的读写锁（类似 Linux 的 percpu-rwsem / brlock）。
+ *
+ * 每个线程第一次使用时被分配到一个槽位，加读锁只修改自己槽位的计数，
+ * 槽位数不少于核心数时，并发的读者之间不会争抢同一个缓存行。
+ * 写者先设置 writer_，再等待所有槽位的计数归零，因此加写锁的代价与槽位数成正比。
+ * 读者看到 writer_ 时撤销计数并等待，写者不会被源源不断的读者饿死。
+ * 满足 SharedMutex 的要求，可以配合 std::shared_lock / std::unique_lock 使用。
+ */
+class PerCoreRWLock {
+ public:
+  /**
+   * slots 为 0 时取不小于硬件线程数的 2 的幂。
+   */
+  explicit PerCoreRWLock(size_t slots = 0) {
+    size_t want = slots > 0 ? slots : std::thread::hardware_concurrency();
+    size_t n = 1;
+    while (n < want) {
+      n <<= 1;
+    }
+    mask_ = n - 1;
+    readers_.reset(new Slot[n]);
+  }
+
+  PerCoreRWLock(const PerCoreRWLock &) = delete;
+  PerCoreRWLock &operator=(const PerCoreRWLock &) = delete;
+
+  void lock_shared() {
+    Slot &slot = my_slot();
+    Backoff backoff;
+    while (!try_enter(slot)) {
+      while (writer_.load(std::memory_order_relaxed)) {
+        backoff.pause();
+      }
+    }
+  }
+
+  bool try_lock_shared() { return try_enter(my_slot()); }
+
+  void unlock_shared() {
+    my_slot().count.fetch_sub(1, std::memory_order_release);
+  }
+
+  void lock() {
+    writer_mtx_.lock();
+    writer_.store(true, std::memory_order_seq_cst);
+    wait_for_readers();
+  }
+
+  bool try_lock() {
+    if (!writer_mtx_.try_lock()) {
+      return false;
+    }
+    writer_.store(true, std::memory_order_seq_cst);
+    for (size_t i = 0; i <= mask_; ++i) {
+      if (readers_[i].count.load(std::memory_order_seq_cst) != 0) {
+        unlock();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void unlock() {
+    writer_.store(false, std::memory_order_release);
+    writer_mtx_.unlock();
+  }
+
+  size_t slots() const { return mask_ + 1; }
+
+ private:
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<int> count{0};
+  };
+
+  Slot &my_slot() { return readers_[thread_index() & mask_]; }
+
+  static size_t thread_index() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+
+  /**
+   * 先登记再检查 writer_，与写者的 “设置 writer_ -> 检查计数” 都是 seq_cst，
+   * 两边至少有一方能看到对方。
+   */
+  bool try_enter(Slot &slot) {
+    slot.count.fetch_add(1, std::memory_order_seq_cst);
+    if (!writer_.load(std::memory_order_seq_cst)) {
+      return true;
+    }
+    slot.count.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void wait_for_readers() {
+    for (size_t i = 0; i <= mask_; ++i) {
+      Backoff backoff;
+      while (readers_[i].count.load(std::memory_order_seq_cst) != 0) {
+        backoff.pause();
+      }
+    }
+  }
+
+  size_t mask_ = 0;
+  std::unique_ptr<Slot[]> readers_;
+  alignas(kCacheLineSize) std::atomic<bool> writer_{false};
+  std::mutex writer_mtx_;
+};
+
+#endif /* MEMORY_MODEL_RW_LOCK_H */
@@ -0,0 +1,112 @@
+#ifndef MEMORY_MODEL_SEQ_LOCK_H
+#define MEMORY_MODEL_SEQ_LOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#include "SpinLock.h"
+
+/**
+ * 顺序锁：保护一个可平凡拷贝的值，适合读多写少、值比较小的场景。
+ *
+ * 写者先把序号加一（变为奇数），写完再加一（变为偶数）；
+ * 读者记下序号后拷贝数据，再检查序号没有变化且为偶数，否则重试。
+ * 读者不写任何共享内存，读多少次都不会让缓存行在核心之间来回迁移；
+ * 代价是写得频繁时读者可能反复重试。
+ * 数据按 8 字节存放在 relaxed 原子变量里，读写并发时不是数据竞争。
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock requires a trivially copyable type");
+
+ public:
+  SeqLock() : SeqLock(T()) {}
+
+  explicit SeqLock(const T &value) { store_words(value); }
+
+  SeqLock(const SeqLock &) = delete;
+  SeqLock &operator=(const SeqLock &) = delete;
+
+  T load() const {
+    Backoff backoff;
+    T value;
+    while (!try_load(value)) {
+      backoff.pause();
+    }
+    return value;
+  }
+
+  /**
+   * 读一次，期间有写者时返回 false。
+   */
+  bool try_load(T &value) const {
+    uint32_t seq0 = seq_.load(std::memory_order_acquire);
+    if (seq0 & 1) {
+      return false;
+    }
+    uint64_t buffer[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+      buffer[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != seq0) {
+      return false;
+    }
+    std::memcpy(&value, buffer, sizeof(T));
+    return true;
+  }
+
+  /**
+   * 多个写者之间用自旋锁互斥。
+   */
+  void store(const T &value) {
+    std::lock_guard<SpinLock> locker(writer_);
+    publish(value);
+  }
+
+  /**
+   * 读-改-写：在写者锁内对当前值调用 f。
+   */
+  template <typename F>
+  void update(F &&f) {
+    std::lock_guard<SpinLock> locker(writer_);
+    T value;
+    uint64_t buffer[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+      buffer[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&value, buffer, sizeof(T));
+    f(value);
+    publish(value);
+  }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+  // 调用方持有 writer_
+  void publish(const T &value) {
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store_words(value);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  void store_words(const T &value) {
+    uint64_t buffer[kWords] = {};
+    std::memcpy(buffer, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; ++i) {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+  }
+
+  alignas(kCacheLineSize) std::atomic<uint32_t> seq_{0};
+  std::atomic<uint64_t> words_[kWords];
+  SpinLock writer_;
+};
+
+#endif /* MEMORY_MODEL_SEQ_LOCK_H */
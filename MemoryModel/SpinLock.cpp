@@ -1,9 +1,14 @@
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "SpinLock.h"
+
 std::atomic_flag lock = ATOMIC_FLAG_INIT;
 
 /*
@@ -33,24 +38,6 @@ void Test_f() {
   for (auto &t : v) t.join();
 }
 
-/**
- * SpinLock should be noncopyable.
- */
-class SpinLock {
- public:
-  SpinLock() : flag_(ATOMIC_FLAG_INIT) {};
-
-  void lock() {
-    while (flag_.test_and_set(std::memory_order_acquire)) {
-    }
-  }
-
-  void unlock() { flag_.clear(std::memory_order_release); }
-
- private:
-  std::atomic_flag flag_;
-};
-
 void TestSpinLock() {
   SpinLock spinlock;
   std::thread t1([&spinlock]() {
@@ -77,7 +64,113 @@ void TestSpinLock() {
   t2.join();
 }
 
+/**
+ * 多个线程在锁内累加同一个普通变量，结果正确说明互斥成立。
+ */
+template <class Lock>
+void TestCounter(const char *name) {
+  const int kThreads = 8;
+  const int kIterations = 20000;
+  Lock lock;
+  int64_t cnt = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kIterations; ++i) {
+        std::lock_guard<Lock> locker(lock);
+        ++cnt;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::cout << name << ": " << cnt << " (expected " << kThreads * kIterations
+            << ")" << std::endl;
+}
+
+/**
+ * 线程数远多于核心数，一半的加锁走 try_lock，另一半走 lock（会 park），
+ * 检查不会丢失唤醒。看门狗保证测试一定会结束：超时说明有线程永远在休眠。
+ */
+void TestParkingContention() {
+  const int kThreads = 32;
+  const int kIterations = 5000;
+  ParkingSpinLock lock;
+  int64_t cnt = 0;
+  std::atomic<bool> done{false};
+  std::thread watchdog([&done]() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while (!done.load()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        std::cout << "ParkingSpinLock contention: FAILED (lost wakeup)"
+                  << std::endl;
+        std::_Exit(1);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kIterations; ++i) {
+        if ((i + t) % 2 == 0) {
+          while (!lock.try_lock()) {
+            std::this_thread::yield();
+          }
+        } else {
+          lock.lock();
+        }
+        ++cnt;
+        if (i % 64 == 0) {
+          // 持锁时让出 CPU，让等锁的线程用完退避进入休眠
+          std::this_thread::yield();
+        }
+        lock.unlock();
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  done.store(true);
+  watchdog.join();
+  std::cout << "ParkingSpinLock contention: " << cnt << " (expected "
+            << kThreads * kIterations << ")" << std::endl;
+}
+
+void TestMcsGuard() {
+  McsLock lock;
+  int cnt = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 10000; ++i) {
+        McsLock::Guard guard(lock);
+        ++cnt;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::cout << "McsLock::Guard: " << cnt << " (expected 40000)" << std::endl;
+
+  // 同一个线程同时持有两把 MCS 锁，各自使用不同的节点
+  McsLock a, b;
+  std::lock_guard<McsLock> la(a);
+  std::lock_guard<McsLock> lb(b);
+  std::cout << "nested McsLock ok" << std::endl;
+}
+
 int main() {
   // Test_f();
   TestSpinLock();
+  TestCounter<SpinLock>("SpinLock");
+  TestCounter<ParkingSpinLock>("ParkingSpinLock");
+  TestCounter<TicketLock>("TicketLock");
+  TestCounter<McsLock>("McsLock");
+  TestParkingContention();
+  TestMcsGuard();
+  std::cout << "alignof(SpinLock) = " << alignof(SpinLock) << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+#ifndef MEMORY_MODEL_SPIN_LOCK_H
+#define MEMORY_MODEL_SPIN_LOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+constexpr size_t kCacheLineSize = 64;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/**
+ * 指数退避：前几轮每次 pause 的次数翻倍，超过上限后改为让出 CPU，
+ * 避免线程数多于核心数时持锁线程得不到运行。
+ */
+class Backoff {
+ public:
+  void pause() {
+    if (step_ <= kSpinSteps) {
+      for (int i = 0; i < (1 << step_); ++i) {
+        cpu_relax();
+      }
+      ++step_;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  // 已经自旋了足够长的时间，调用方可以考虑休眠
+  bool exhausted() const { return step_ > kSpinSteps; }
+
+  void reset() { step_ = 0; }
+
+ private:
+  static constexpr int kSpinSteps = 6;
+
+  int step_ = 0;
+};
+
+namespace detail {
+
+inline void futex_wait(std::atomic<int> *addr, int expected) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT_PRIVATE,
+          expected, nullptr, nullptr, 0);
+#else
+  (void)addr;
+  (void)expected;
+  std::this_thread::yield();
+#endif
+}
+
+inline void futex_wake_one(std::atomic<int> *addr) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE_PRIVATE, 1,
+          nullptr, nullptr, 0);
+#else
+  (void)addr;
+#endif
+}
+
+}  // namespace detail
+
+/**
+ * test-and-test-and-set 自旋锁，独占一个缓存行。
+ *
+ * 等锁时只读 state_（读操作命中本地缓存，不产生总线流量），
+ * 看到锁空闲才尝试 exchange，并在两次尝试之间指数退避。
+ * Park 为 true 时，退避用完后通过 futex 休眠（非 Linux 平台退化为 yield），
+ * 适合临界区偶尔较长的场景；此时 state_ 为 2 表示可能有线程在休眠，解锁时需要唤醒。
+ */
+template <bool Park>
+class alignas(kCacheLineSize) BasicSpinLock {
+ public:
+  BasicSpinLock() = default;
+  BasicSpinLock(const BasicSpinLock &) = delete;
+  BasicSpinLock &operator=(const BasicSpinLock &) = delete;
+
+  void lock() {
+    if (try_lock()) {
+      return;
+    }
+    Backoff backoff;
+    while (true) {
+      while (state_.load(std::memory_order_relaxed) != 0) {
+        if (Park && backoff.exhausted()) {
+          park();
+          return;
+        }
+        backoff.pause();
+      }
+      if (try_lock()) {
+        return;
+      }
+    }
+  }
+
+  bool try_lock() {
+    // 必须用 CAS 而不是 exchange(1)：Park 时 state_ 在 load 之后可能被休眠方改成 2，
+    // exchange 会把 2 覆盖成 1，持锁方解锁时就不再唤醒休眠的线程
+    int expected = 0;
+    return state_.load(std::memory_order_relaxed) == 0 &&
+           state_.compare_exchange_strong(expected, 1,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    if constexpr (Park) {
+      if (state_.exchange(0, std::memory_order_release) == 2) {
+        detail::futex_wake_one(&state_);
+      }
+    } else {
+      state_.store(0, std::memory_order_release);
+    }
+  }
+
+ private:
+  // 与 Drepper 的 futex mutex 相同：拿到锁时把状态设为 2，保证解锁方会唤醒其他休眠者
+  void park() {
+    while (state_.exchange(2, std::memory_order_acquire) != 0) {
+      detail::futex_wait(&state_, 2);
+    }
+  }
+
+  // 0 空闲，1 加锁，2 加锁且可能有线程休眠（只在 Park 时出现）
+  std::atomic<int> state_{0};
+};
+
+using SpinLock = BasicSpinLock<false>;
+using ParkingSpinLock = BasicSpinLock<true>;
+
+/**
+ * 排号锁：按到达顺序获得锁，是公平的。
+ * 等待者只读 serving_，与取号用的 next_ 位于不同的缓存行。
+ * 线程数多于核心数时，轮到的线程可能没有在运行，其他线程只能空等，吞吐会急剧下降。
+ */
+class TicketLock {
+ public:
+  TicketLock() = default;
+  TicketLock(const TicketLock &) = delete;
+  TicketLock &operator=(const TicketLock &) = delete;
+
+  void lock() {
+    uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+    Backoff backoff;
+    while (serving_.load(std::memory_order_acquire) != ticket) {
+      backoff.pause();
+    }
+  }
+
+  bool try_lock() {
+    uint32_t serving = serving_.load(std::memory_order_relaxed);
+    uint32_t expected = serving;
+    return next_.compare_exchange_strong(expected, serving + 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    // 只有持锁线程会写 serving_
+    serving_.store(serving_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+  }
+
+ private:
+  alignas(kCacheLineSize) std::atomic<uint32_t> next_{0};
+  alignas(kCacheLineSize) std::atomic<uint32_t> serving_{0};
+};
+
+/**
+ * MCS 队列锁：等待者组成链表，每个线程只在自己的节点上自旋，
+ * 释放锁时只写下一个等待者的节点，竞争再激烈也只有一次缓存行转移，并且是公平的。
+ *
+ * 节点可以由调用方提供（放在栈上，配合 Guard 使用）；
+ * 直接调用 lock/unlock 时从线程局部的缓存中取节点，因此也能用于 std::lock_guard。
+ */
+class McsLock {
+ public:
+  struct alignas(kCacheLineSize) Node {
+    std::atomic<Node *> next{nullptr};
+    std::atomic<bool> locked{false};
+  };
+
+  /**
+   * 使用栈上节点的 RAII 加锁。
+   */
+  class Guard {
+   public:
+    explicit Guard(McsLock &lock) : lock_(lock) { lock_.lock(node_); }
+    ~Guard() { lock_.unlock(node_); }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+   private:
+    McsLock &lock_;
+    Node node_;
+  };
+
+  McsLock() = default;
+  McsLock(const McsLock &) = delete;
+  McsLock &operator=(const McsLock &) = delete;
+
+  void lock(Node &node) {
+    node.next.store(nullptr, std::memory_order_relaxed);
+    node.locked.store(true, std::memory_order_relaxed);
+    Node *prev = tail_.exchange(&node, std::memory_order_acq_rel);
+    if (prev == nullptr) {
+      return;
+    }
+    prev->next.store(&node, std::memory_order_release);
+    Backoff backoff;
+    while (node.locked.load(std::memory_order_acquire)) {
+      backoff.pause();
+    }
+  }
+
+  void unlock(Node &node) {
+    Node *next = node.next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      Node *expected = &node;
+      if (tail_.compare_exchange_strong(expected, nullptr,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+        return;
+      }
+      // 后继者已经排上队，但还没来得及链到 node 上
+      Backoff backoff;
+      while ((next = node.next.load(std::memory_order_acquire)) == nullptr) {
+        backoff.pause();
+      }
+    }
+    next->locked.store(false, std::memory_order_release);
+  }
+
+  void lock() {
+    Node *node = acquire_node();
+    lock(*node);
+    owner_node_ = node;
+  }
+
+  void unlock() {
+    // 持锁期间只有持锁线程访问 owner_node_
+    Node *node = owner_node_;
+    unlock(*node);
+    release_node(node);
+  }
+
+ private:
+  static std::vector<std::unique_ptr<Node>> &node_cache() {
+    thread_local std::vector<std::unique_ptr<Node>> cache;
+    return cache;
+  }
+
+  static Node *acquire_node() {
+    auto &cache = node_cache();
+    if (cache.empty()) {
+      return new Node();
+    }
+    Node *node = cache.back().release();
+    cache.pop_back();
+    return node;
+  }
+
+  static void release_node(Node *node) {
+    node_cache().emplace_back(node);
+  }
+
+  alignas(kCacheLineSize) std::atomic<Node *> tail_{nullptr};
+  Node *owner_node_ = nullptr;
+};
+
+#endif /* MEMORY_MODEL_SPIN_LOCK_H */
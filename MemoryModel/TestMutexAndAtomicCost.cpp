@@ -1,67 +1,310 @@
 /**
- * 比较 atomic 和 mutex 性能开销
+ * 比较 atomic 和 mutex 等同步原语在竞争下的开销，结果输出为 CSV（默认）或每行一个 JSON 对象。
+ *
+ *   ./TestMutexAndAtomicCost [--json] [--max-threads=N] [--ops=N]
+ *
+ *  - atomic_*：所有线程对同一个 atomic 做 fetch_add，比较不同的内存序；
+ *  - false_sharing / padded：每个线程各自计数，计数器相邻（共享缓存行）或按缓存行对齐；
+ *  - sharded：计数分散到按缓存行对齐的分片上，读取时求和；
+ *  - mutex / spinlock / futex / ticket / mcs：在锁内累加同一个普通变量。
+ * 线程数从 1 按 2 的幂增加到全部核心。ns_per_op 是总耗时除以总操作数（吞吐的倒数），
+ * thread_ns_per_op 再乘以线程数，表示单个线程看到的每次操作的平均耗时。
  */
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
-void TestMutexCost() {
-  std::mutex mtx;
+#include "SpinLock.h"
 
-  int cnt = 0;
-  auto f = [&]() {
-    for (int i = 0; i < 10000000; ++i) {
-      std::unique_lock<std::mutex> locker(mtx);
-      ++cnt;
+constexpr size_t kCacheLine = kCacheLineSize;
+
+/**
+ * 最简单的自旋锁：test_and_set 失败就立即重试。
+ */
+class TasSpinLock {
+ public:
+  void lock() {
+    while (flag_.test_and_set(std::memory_order_acquire)) {
     }
+  }
+
+  void unlock() { flag_.clear(std::memory_order_release); }
+
+ private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * 基于 futex 的互斥量（Ulrich Drepper, "Futexes Are Tricky" 中的 mutex3）。
+ * state_：0 未加锁，1 加锁且没有等待者，2 加锁且可能有等待者。
+ * 没有竞争时加锁、解锁各只有一次原子操作，不进入内核。
+ */
+class FutexLock {
+ public:
+  void lock() {
+    int c = 0;
+    if (state_.compare_exchange_strong(c, 1, std::memory_order_acquire)) {
+      return;
+    }
+    if (c != 2) {
+      c = state_.exchange(2, std::memory_order_acquire);
+    }
+    while (c != 0) {
+      detail::futex_wait(&state_, 2);
+      c = state_.exchange(2, std::memory_order_acquire);
+    }
+  }
+
+  void unlock() {
+    if (state_.exchange(0, std::memory_order_release) == 2) {
+      detail::futex_wake_one(&state_);
+    }
+  }
+
+ private:
+  std::atomic<int> state_{0};
+};
+
+/**
+ * 分片计数器：每个线程固定写一个分片，分片之间不共享缓存行。
+ */
+class ShardedCounter {
+ public:
+  explicit ShardedCounter(size_t shards) : shards_(new Shard[shards]), n_(shards) {}
+
+  void add(size_t shard, int64_t delta) {
+    shards_[shard % n_].value.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  int64_t load() const {
+    int64_t sum = 0;
+    for (size_t i = 0; i < n_; ++i) {
+      sum += shards_[i].value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(kCacheLine) Shard {
+    std::atomic<int64_t> value{0};
   };
 
-  std::vector<std::thread> pool;
+  std::unique_ptr<Shard[]> shards_;
+  size_t n_;
+};
+
+struct Result {
+  std::string benchmark;
+  int threads = 0;
+  int64_t ops = 0;
+  double seconds = 0;
+  // 用于检查结果是否正确
+  int64_t checksum = 0;
 
-  auto start_time = std::chrono::system_clock::now();
+  double ns_per_op() const { return ops > 0 ? seconds * 1e9 / ops : 0; }
 
-  for (int i = 0; i < 4; ++i) {
-    pool.emplace_back(f);
+  double thread_ns_per_op() const { return ns_per_op() * threads; }
+};
+
+/**
+ * 启动 threads 个线程，全部就绪后同时执行 body(thread_index)，只统计执行部分的时间。
+ */
+double run_threads(int threads, const std::function<void(int)> &body) {
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      body(t);
+    });
   }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
   for (auto &t : pool) {
-    if (t.joinable()) {
-      t.join();
+    t.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+Result make_result(const std::string &name, int threads, int64_t ops_per_thread,
+                   double seconds, int64_t checksum) {
+  Result result;
+  result.benchmark = name;
+  result.threads = threads;
+  result.ops = ops_per_thread * threads;
+  result.seconds = seconds;
+  result.checksum = checksum;
+  return result;
+}
+
+Result BenchAtomic(std::memory_order order, const std::string &name, int threads,
+                   int64_t ops) {
+  alignas(kCacheLine) std::atomic<int64_t> cnt{0};
+  double seconds = run_threads(threads, [&](int) {
+    for (int64_t i = 0; i < ops; ++i) {
+      cnt.fetch_add(1, order);
+    }
+  });
+  return make_result(name, threads, ops, seconds, cnt.load());
+}
+
+Result BenchCasLoop(int threads, int64_t ops) {
+  alignas(kCacheLine) std::atomic<int64_t> cnt{0};
+  double seconds = run_threads(threads, [&](int) {
+    for (int64_t i = 0; i < ops; ++i) {
+      int64_t expected = cnt.load(std::memory_order_relaxed);
+      while (!cnt.compare_exchange_weak(expected, expected + 1,
+                                        std::memory_order_relaxed)) {
+      }
     }
+  });
+  return make_result("atomic_cas_loop", threads, ops, seconds, cnt.load());
+}
+
+/**
+ * 每个线程只写自己的计数器；Slot 决定相邻计数器之间的距离。
+ */
+template <class Slot>
+Result BenchPerThread(const std::string &name, int threads, int64_t ops) {
+  std::unique_ptr<Slot[]> counters(new Slot[threads]);
+  double seconds = run_threads(threads, [&](int t) {
+    auto &cnt = counters[t].value;
+    for (int64_t i = 0; i < ops; ++i) {
+      cnt.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  int64_t sum = 0;
+  for (int t = 0; t < threads; ++t) {
+    sum += counters[t].value.load();
   }
+  return make_result(name, threads, ops, seconds, sum);
+}
+
+struct PackedSlot {
+  std::atomic<int64_t> value{0};
+};
+
+struct alignas(kCacheLine) PaddedSlot {
+  std::atomic<int64_t> value{0};
+};
 
-  auto total_time = std::chrono::system_clock::now() - start_time;
-  std::cout << "TestMutexCost: " << total_time.count() << std::endl;
+Result BenchSharded(int threads, int64_t ops) {
+  ShardedCounter cnt(threads);
+  double seconds = run_threads(threads, [&](int t) {
+    for (int64_t i = 0; i < ops; ++i) {
+      cnt.add(t, 1);
+    }
+  });
+  return make_result("sharded", threads, ops, seconds, cnt.load());
 }
 
-void TestAtomicCost() {
-  std::atomic<int> cnt = 0;
-  auto f = [&]() {
-    for (int i = 0; i < 10000000; ++i) {
+template <class Lock>
+Result BenchLock(const std::string &name, int threads, int64_t ops) {
+  Lock lock;
+  int64_t cnt = 0;
+  double seconds = run_threads(threads, [&](int) {
+    for (int64_t i = 0; i < ops; ++i) {
+      std::lock_guard<Lock> locker(lock);
       ++cnt;
     }
-  };
+  });
+  return make_result(name, threads, ops, seconds, cnt);
+}
 
-  std::vector<std::thread> pool;
+void print_header(bool json) {
+  if (!json) {
+    std::cout << "benchmark,threads,ops,seconds,ns_per_op,thread_ns_per_op,"
+                 "checksum"
+              << std::endl;
+  }
+}
 
-  auto start_time = std::chrono::system_clock::now();
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark
+              << "\",\"threads\":" << r.threads << ",\"ops\":" << r.ops
+              << ",\"seconds\":" << r.seconds
+              << ",\"ns_per_op\":" << r.ns_per_op()
+              << ",\"thread_ns_per_op\":" << r.thread_ns_per_op()
+              << ",\"checksum\":" << r.checksum << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.threads << "," << r.ops << ","
+              << r.seconds << "," << r.ns_per_op() << ","
+              << r.thread_ns_per_op() << "," << r.checksum << std::endl;
+  }
+  if (r.checksum != r.ops) {
+    std::cerr << r.benchmark << ": expected " << r.ops << ", got "
+              << r.checksum << std::endl;
+  }
+}
 
-  for (int i = 0; i < 4; ++i) {
-    pool.emplace_back(f);
+/**
+ * 1, 2, 4, ... 直到 max（包含 max）。
+ */
+std::vector<int> powers_of_two(int max) {
+  std::vector<int> counts;
+  for (int n = 1; n < max; n *= 2) {
+    counts.push_back(n);
   }
-  for (auto &t : pool) {
-    if (t.joinable()) {
-      t.join();
+  counts.push_back(max);
+  return counts;
+}
+
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  int64_t ops = 2000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-threads=", 0) == 0) {
+      max_threads = std::max(1, std::stoi(arg.substr(14)));
+    } else if (arg.rfind("--ops=", 0) == 0) {
+      ops = std::max<int64_t>(1, std::stoll(arg.substr(6)));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--json] [--max-threads=N] [--ops=N]" << std::endl;
+      return 1;
     }
   }
 
-  auto total_time = std::chrono::system_clock::now() - start_time;
-  std::cout << "TestAtomicCost: " << total_time.count() << std::endl;
+  print_header(json);
+  for (int threads : powers_of_two(max_threads)) {
+    // 每个线程的操作数固定，线程越多总操作数越多
+    print(BenchAtomic(std::memory_order_relaxed, "atomic_relaxed", threads, ops),
+          json);
+    print(BenchAtomic(std::memory_order_acq_rel, "atomic_acq_rel", threads, ops),
+          json);
+    print(BenchAtomic(std::memory_order_seq_cst, "atomic_seq_cst", threads, ops),
+          json);
+    print(BenchCasLoop(threads, ops), json);
+    print(BenchPerThread<PackedSlot>("false_sharing", threads, ops), json);
+    print(BenchPerThread<PaddedSlot>("padded", threads, ops), json);
+    print(BenchSharded(threads, ops), json);
+    print(BenchLock<std::mutex>("mutex", threads, ops), json);
+    print(BenchLock<TasSpinLock>("spinlock_tas", threads, ops), json);
+    print(BenchLock<SpinLock>("spinlock_ttas", threads, ops), json);
+    print(BenchLock<ParkingSpinLock>("spinlock_parking", threads, ops), json);
+    print(BenchLock<TicketLock>("ticket", threads, ops), json);
+    print(BenchLock<McsLock>("mcs", threads, ops), json);
+    print(BenchLock<FutexLock>("futex", threads, ops), json);
+  }
 }
-
-int main() {
-  TestAtomicCost();
-  TestMutexCost();
-}
\ No newline at end of file
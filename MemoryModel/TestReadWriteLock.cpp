@@ -0,0 +1,228 @@
+/**
+ * 读多写少场景下比较 std::shared_mutex、PerCoreRWLock 和 SeqLock，
+ * 结果输出为 CSV（默认）或每行一个 JSON 对象。
+ *
+ *   ./TestReadWriteLock [--json] [--max-threads=N] [--ops=N]
+ *
+ * 共享数据是一份小配置，写者把所有字段改成同一个新值，读者检查读到的字段是否一致。
+ * 每个线程按 write_permille（千分比）随机决定读或写，线程数从 1 按 2 的幂增加到全部核心。
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RWLock.h"
+#include "SeqLock.h"
+
+struct Config {
+  int64_t version = 0;
+  int64_t sample_rate = 0;
+  int64_t frame_size = 0;
+  int64_t channels = 0;
+
+  bool consistent() const {
+    return sample_rate == version && frame_size == version &&
+           channels == version;
+  }
+
+  void set(int64_t v) { version = sample_rate = frame_size = channels = v; }
+};
+
+/**
+ * 用读写锁保护 Config。
+ */
+template <class Mutex>
+class LockedConfig {
+ public:
+  Config load() {
+    std::shared_lock<Mutex> locker(mtx_);
+    return config_;
+  }
+
+  void bump() {
+    std::unique_lock<Mutex> locker(mtx_);
+    config_.set(config_.version + 1);
+  }
+
+ private:
+  Mutex mtx_;
+  Config config_;
+};
+
+class SeqLockConfig {
+ public:
+  Config load() { return config_.load(); }
+
+  void bump() {
+    config_.update([](Config &config) { config.set(config.version + 1); });
+  }
+
+ private:
+  SeqLock<Config> config_;
+};
+
+struct Result {
+  std::string benchmark;
+  int threads = 0;
+  int write_permille = 0;
+  int64_t ops = 0;
+  double seconds = 0;
+  // 读到不一致数据的次数，应该为 0
+  int64_t torn = 0;
+
+  double ns_per_op() const { return ops > 0 ? seconds * 1e9 / ops : 0; }
+
+  double thread_ns_per_op() const { return ns_per_op() * threads; }
+};
+
+double run_threads(int threads, const std::function<void(int)> &body) {
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      body(t);
+    });
+  }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &t : pool) {
+    t.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <class Shared>
+Result Bench(const std::string &name, int threads, int write_permille,
+             int64_t ops) {
+  Shared shared;
+  std::atomic<int64_t> torn{0};
+  double seconds = run_threads(threads, [&](int t) {
+    uint64_t rng = 0x9E3779B97F4A7C15ull * (t + 1);
+    int64_t local_torn = 0;
+    for (int64_t i = 0; i < ops; ++i) {
+      rng ^= rng << 13;
+      rng ^= rng >> 7;
+      rng ^= rng << 17;
+      if (static_cast<int>(rng % 1000) < write_permille) {
+        shared.bump();
+      } else if (!shared.load().consistent()) {
+        ++local_torn;
+      }
+    }
+    torn.fetch_add(local_torn);
+  });
+
+  Result result;
+  result.benchmark = name;
+  result.threads = threads;
+  result.write_permille = write_permille;
+  result.ops = ops * threads;
+  result.seconds = seconds;
+  result.torn = torn.load();
+  return result;
+}
+
+void print_header(bool json) {
+  if (!json) {
+    std::cout << "benchmark,threads,write_permille,ops,seconds,ns_per_op,"
+                 "thread_ns_per_op,torn"
+              << std::endl;
+  }
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark
+              << "\",\"threads\":" << r.threads
+              << ",\"write_permille\":" << r.write_permille
+              << ",\"ops\":" << r.ops << ",\"seconds\":" << r.seconds
+              << ",\"ns_per_op\":" << r.ns_per_op()
+              << ",\"thread_ns_per_op\":" << r.thread_ns_per_op()
+              << ",\"torn\":" << r.torn << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.threads << "," << r.write_permille
+              << "," << r.ops << "," << r.seconds << "," << r.ns_per_op()
+              << "," << r.thread_ns_per_op() << "," << r.torn << std::endl;
+  }
+}
+
+/**
+ * 1, 2, 4, ... 直到 max（包含 max）。
+ */
+std::vector<int> powers_of_two(int max) {
+  std::vector<int> counts;
+  for (int n = 1; n < max; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max);
+  return counts;
+}
+
+/**
+ * 读写混合下检查两种锁的互斥性：写者之间互斥，读者不会看到写了一半的数据。
+ */
+void TestReadWriteLock() {
+  Result a = Bench<LockedConfig<PerCoreRWLock>>("PerCoreRWLock", 8, 100, 20000);
+  Result b = Bench<SeqLockConfig>("SeqLock", 8, 100, 20000);
+  std::cerr << "PerCoreRWLock torn: " << a.torn
+            << ", SeqLock torn: " << b.torn << std::endl;
+
+  PerCoreRWLock lock(4);
+  std::shared_lock<PerCoreRWLock> r1(lock);
+  std::cerr << "try_lock with reader: " << lock.try_lock()
+            << ", try_lock_shared: " << lock.try_lock_shared() << std::endl;
+  lock.unlock_shared();
+}
+
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  int64_t ops = 1000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-threads=", 0) == 0) {
+      max_threads = std::max(1, std::stoi(arg.substr(14)));
+    } else if (arg.rfind("--ops=", 0) == 0) {
+      ops = std::max<int64_t>(1, std::stoll(arg.substr(6)));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--json] [--max-threads=N] [--ops=N]" << std::endl;
+      return 1;
+    }
+  }
+
+  TestReadWriteLock();
+  print_header(json);
+  for (int threads : powers_of_two(max_threads)) {
+    for (int write_permille : {0, 1, 10, 100, 500}) {
+      print(Bench<LockedConfig<std::shared_mutex>>("shared_mutex", threads,
+                                                   write_permille, ops),
+            json);
+      print(Bench<LockedConfig<PerCoreRWLock>>("PerCoreRWLock", threads,
+                                               write_permille, ops),
+            json);
+      print(Bench<SeqLockConfig>("SeqLock", threads, write_permille, ops),
+            json);
+    }
+  }
+}
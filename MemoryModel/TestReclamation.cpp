@@ -0,0 +1,415 @@
+/**
+ * 无锁栈、无锁队列在两种内存回收策略下的正确性测试和基准测试，
+ * 基准结果输出为 CSV（默认）或每行一个 JSON 对象。
+ *
+ *   ./TestReclamation [--json] [--max-threads=N] [--ops=N]
+ *
+ *  - guard_*：只做 “进入临界区 + 读一个指针”，即每次操作读路径上的回收开销；
+ *  - stack_* / queue_*：每个线程交替 push 和 pop；
+ *    none 表示运行期间不回收（节点在全部线程结束后统一释放），
+ *    与 epoch / hazard 的差值就是回收的代价；mutex 是加锁的 std::stack / std::queue。
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <stack>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EpochReclamation.h"
+#include "HazardPointer.h"
+#include "LockFreeQueue.h"
+#include "LockFreeStack.h"
+
+/**
+ * 统计存活对象数，检查节点是否都被释放。
+ */
+struct Tracked {
+  static std::atomic<int64_t> alive;
+
+  explicit Tracked(int64_t v = 0) : value(v) { alive.fetch_add(1); }
+  Tracked(const Tracked &other) : value(other.value) { alive.fetch_add(1); }
+  Tracked &operator=(const Tracked &) = default;
+  ~Tracked() { alive.fetch_sub(1); }
+
+  int64_t value;
+};
+
+std::atomic<int64_t> Tracked::alive{0};
+
+/**
+ * 运行期间只记录摘下的节点，全部线程结束后由 free_all 统一释放，作为基准测试的对照。
+ */
+struct NoReclaimer {
+  class Guard {
+   public:
+    template <typename T>
+    T *protect(int /*slot*/, const std::atomic<T *> &src) {
+      return src.load(std::memory_order_acquire);
+    }
+  };
+
+  struct Retired {
+    void *ptr;
+    void (*deleter)(void *);
+  };
+
+  template <typename T>
+  static void retire(T *p) {
+    local().push_back({p, [](void *q) { delete static_cast<T *>(q); }});
+  }
+
+  /**
+   * 线程结束前调用，把本线程记录的节点交出去。
+   */
+  static void flush_thread() {
+    std::lock_guard<std::mutex> locker(mtx());
+    all().insert(all().end(), local().begin(), local().end());
+    local().clear();
+  }
+
+  static void free_all() {
+    for (auto &r : all()) {
+      r.deleter(r.ptr);
+    }
+    all().clear();
+  }
+
+ private:
+  static std::vector<Retired> &local() {
+    thread_local std::vector<Retired> retired;
+    return retired;
+  }
+
+  static std::vector<Retired> &all() {
+    static std::vector<Retired> retired;
+    return retired;
+  }
+
+  static std::mutex &mtx() {
+    static std::mutex mtx;
+    return mtx;
+  }
+};
+
+template <class Reclaimer>
+struct ReclaimerTraits;
+
+template <>
+struct ReclaimerTraits<EpochReclaimer> {
+  static const char *name() { return "epoch"; }
+  static void flush_thread() {}
+  static void free_all() {
+    // 纪元需要前进两次，节点才能释放
+    for (int i = 0; i < 3; ++i) {
+      EpochDomain::instance().collect();
+    }
+  }
+};
+
+template <>
+struct ReclaimerTraits<HazardReclaimer> {
+  static const char *name() { return "hazard"; }
+  static void flush_thread() {}
+  static void free_all() { HazardDomain::instance().reclaim(); }
+};
+
+template <>
+struct ReclaimerTraits<NoReclaimer> {
+  static const char *name() { return "none"; }
+  static void flush_thread() { NoReclaimer::flush_thread(); }
+  static void free_all() { NoReclaimer::free_all(); }
+};
+
+/**
+ * 加锁的 std::stack / std::queue，接口与无锁版本一致。
+ */
+template <typename T>
+class LockedStack {
+ public:
+  void push(const T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    stack_.push(value);
+  }
+
+  bool pop(T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    if (stack_.empty()) {
+      return false;
+    }
+    value = stack_.top();
+    stack_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mtx_;
+  std::stack<T> stack_;
+};
+
+template <typename T>
+class LockedQueue {
+ public:
+  void push(const T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    queue_.push(value);
+  }
+
+  bool pop(T &value) {
+    std::lock_guard<std::mutex> locker(mtx_);
+    if (queue_.empty()) {
+      return false;
+    }
+    value = queue_.front();
+    queue_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mtx_;
+  std::queue<T> queue_;
+};
+
+/**
+ * 生产者写入 (生产者编号 << 32 | 序号)，消费者检查总数、总和；
+ * 队列还要检查同一个生产者的元素按顺序出队。
+ */
+template <template <typename, class> class Container, class Reclaimer>
+void TestContainer(const std::string &name, bool fifo) {
+  const int kProducers = 4;
+  const int kConsumers = 4;
+  const int64_t kItems = 20000;
+  {
+    Container<Tracked, Reclaimer> container;
+    std::atomic<int64_t> consumed{0};
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> out_of_order{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+      threads.emplace_back([&, p]() {
+        for (int64_t i = 0; i < kItems; ++i) {
+          container.push(Tracked((int64_t(p) << 32) | i));
+        }
+      });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+      threads.emplace_back([&]() {
+        std::vector<int64_t> last(kProducers, -1);
+        Tracked item;
+        while (consumed.load() < kProducers * kItems) {
+          if (!container.pop(item)) {
+            std::this_thread::yield();
+            continue;
+          }
+          int producer = static_cast<int>(item.value >> 32);
+          int64_t seq = item.value & 0xffffffff;
+          if (fifo && seq <= last[producer]) {
+            out_of_order.fetch_add(1);
+          }
+          last[producer] = seq;
+          sum.fetch_add(seq);
+          consumed.fetch_add(1);
+        }
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+    std::cout << name << "<" << ReclaimerTraits<Reclaimer>::name()
+              << ">: consumed " << consumed.load() << ", sum "
+              << (sum.load() == kProducers * kItems * (kItems - 1) / 2 ? "ok"
+                                                                      : "WRONG")
+              << ", out of order " << out_of_order.load();
+  }
+  ReclaimerTraits<Reclaimer>::free_all();
+  std::cout << ", alive after reclaim " << Tracked::alive.load() << std::endl;
+}
+
+struct Result {
+  std::string benchmark;
+  std::string reclaimer;
+  int threads = 0;
+  int64_t ops = 0;
+  double seconds = 0;
+
+  double ns_per_op() const { return ops > 0 ? seconds * 1e9 / ops : 0; }
+
+  double thread_ns_per_op() const { return ns_per_op() * threads; }
+};
+
+double run_threads(int threads, const std::function<void(int)> &body) {
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      body(t);
+    });
+  }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &t : pool) {
+    t.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <class Reclaimer>
+Result BenchGuard(int threads, int64_t ops) {
+  int value = 0;
+  std::atomic<int *> ptr{&value};
+  std::atomic<int64_t> sink{0};
+  double seconds = run_threads(threads, [&](int) {
+    int64_t local = 0;
+    for (int64_t i = 0; i < ops; ++i) {
+      typename Reclaimer::Guard guard;
+      local += *guard.protect(0, ptr);
+    }
+    sink.fetch_add(local);
+  });
+  Result result;
+  result.benchmark = "guard";
+  result.reclaimer = ReclaimerTraits<Reclaimer>::name();
+  result.threads = threads;
+  result.ops = ops * threads;
+  result.seconds = seconds;
+  return result;
+}
+
+/**
+ * 每个线程交替 push 和 pop，一次 push 或 pop 算一次操作。
+ */
+template <class Container, class Traits>
+Result BenchContainer(const std::string &name, const char *reclaimer,
+                      int threads, int64_t ops) {
+  Result result;
+  {
+    Container container;
+    result.seconds = run_threads(threads, [&](int t) {
+      int64_t value = 0;
+      for (int64_t i = 0; i < ops; ++i) {
+        container.push(int64_t(t) * ops + i);
+        container.pop(value);
+      }
+      Traits::flush_thread();
+    });
+  }
+  Traits::free_all();
+  result.benchmark = name;
+  result.reclaimer = reclaimer;
+  result.threads = threads;
+  result.ops = 2 * ops * threads;
+  return result;
+}
+
+/**
+ * 加锁版本不需要回收。
+ */
+struct NoTraits {
+  static void flush_thread() {}
+  static void free_all() {}
+};
+
+void print_header(bool json) {
+  if (!json) {
+    std::cout << "benchmark,reclaimer,threads,ops,seconds,ns_per_op,"
+                 "thread_ns_per_op"
+              << std::endl;
+  }
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"reclaimer\":\""
+              << r.reclaimer << "\",\"threads\":" << r.threads
+              << ",\"ops\":" << r.ops << ",\"seconds\":" << r.seconds
+              << ",\"ns_per_op\":" << r.ns_per_op()
+              << ",\"thread_ns_per_op\":" << r.thread_ns_per_op() << "}"
+              << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.reclaimer << "," << r.threads << ","
+              << r.ops << "," << r.seconds << "," << r.ns_per_op() << ","
+              << r.thread_ns_per_op() << std::endl;
+  }
+}
+
+/**
+ * 1, 2, 4, ... 直到 max（包含 max）。
+ */
+std::vector<int> powers_of_two(int max) {
+  std::vector<int> counts;
+  for (int n = 1; n < max; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max);
+  return counts;
+}
+
+template <class Reclaimer>
+void run_lock_free(int threads, int64_t ops, bool json) {
+  using Traits = ReclaimerTraits<Reclaimer>;
+  print(BenchContainer<LockFreeStack<int64_t, Reclaimer>, Traits>(
+            "stack", Traits::name(), threads, ops),
+        json);
+  print(BenchContainer<LockFreeQueue<int64_t, Reclaimer>, Traits>(
+            "queue", Traits::name(), threads, ops),
+        json);
+}
+
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  int64_t ops = 500000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-threads=", 0) == 0) {
+      max_threads = std::max(1, std::stoi(arg.substr(14)));
+    } else if (arg.rfind("--ops=", 0) == 0) {
+      ops = std::max<int64_t>(1, std::stoll(arg.substr(6)));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--json] [--max-threads=N] [--ops=N]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestContainer<LockFreeStack, EpochReclaimer>("LockFreeStack", false);
+    TestContainer<LockFreeStack, HazardReclaimer>("LockFreeStack", false);
+    TestContainer<LockFreeQueue, EpochReclaimer>("LockFreeQueue", true);
+    TestContainer<LockFreeQueue, HazardReclaimer>("LockFreeQueue", true);
+  }
+
+  print_header(json);
+  for (int threads : powers_of_two(max_threads)) {
+    print(BenchGuard<NoReclaimer>(threads, ops), json);
+    print(BenchGuard<EpochReclaimer>(threads, ops), json);
+    print(BenchGuard<HazardReclaimer>(threads, ops), json);
+    run_lock_free<NoReclaimer>(threads, ops, json);
+    run_lock_free<EpochReclaimer>(threads, ops, json);
+    run_lock_free<HazardReclaimer>(threads, ops, json);
+    print(BenchContainer<LockedStack<int64_t>, NoTraits>("stack", "mutex",
+                                                         threads, ops),
+          json);
+    print(BenchContainer<LockedQueue<int64_t>, NoTraits>("queue", "mutex",
+                                                         threads, ops),
+          json);
+  }
+}
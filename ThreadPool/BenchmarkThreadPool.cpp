@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "threadpool_v1.h"
+#include "threadpool_v2.h"
+
+/**
+ * 线程池基准测试，结果输出为 CSV（默认）或每行一个 JSON 对象，方便比较不同的调度器。
+ *
+ *   ./BenchmarkThreadPool [--json] [--max-threads=N] [--tasks=N]
+ *
+ *  - empty：P 个生产者提交空任务，W 个工作线程执行，测吞吐；
+ *  - latency：单个生产者分批提交，测每个任务从提交到执行完的延迟分位数；
+ *  - fanout：任务在工作线程中递归提交两个子任务，形成满二叉树，测吞吐。
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * 计数归零时唤醒等待者，计数过程中只有原子操作。初始计数为 0 时 wait 直接返回。
+ */
+class Latch {
+ public:
+  explicit Latch(int64_t count) : count_(count), done_(count <= 0) {}
+
+  void count_down() {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::unique_lock<std::mutex> locker(mtx_);
+      done_ = true;
+      cv_.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> locker(mtx_);
+    cv_.wait(locker, [this]() { return done_; });
+  }
+
+ private:
+  std::atomic<int64_t> count_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool done_;
+};
+
+struct Result {
+  std::string benchmark;
+  std::string pool;
+  int producers = 0;
+  int workers = 0;
+  int64_t tasks = 0;
+  double seconds = 0;
+  // 延迟分位数（纳秒），只有 latency 有
+  int64_t p50_ns = -1;
+  int64_t p90_ns = -1;
+  int64_t p99_ns = -1;
+  int64_t p999_ns = -1;
+
+  double tasks_per_sec() const { return seconds > 0 ? tasks / seconds : 0; }
+};
+
+template <class Pool>
+struct PoolTraits;
+
+template <>
+struct PoolTraits<ThreadPool> {
+  static const char *name() { return "ThreadPool"; }
+
+  // 固定线程数，不受 hardware_concurrency 限制
+  static std::unique_ptr<ThreadPool> make(int workers) {
+    ThreadPoolOptions options;
+    options.min_threads = options.max_threads = workers;
+    return std::unique_ptr<ThreadPool>(new ThreadPool(options));
+  }
+};
+
+template <>
+struct PoolTraits<WorkStealingThreadPool> {
+  static const char *name() { return "WorkStealingThreadPool"; }
+
+  static std::unique_ptr<WorkStealingThreadPool> make(int workers) {
+    return std::unique_ptr<WorkStealingThreadPool>(
+        new WorkStealingThreadPool(workers));
+  }
+};
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <class Pool>
+Result bench_empty(int producers, int workers, int64_t tasks) {
+  auto pool = PoolTraits<Pool>::make(workers);
+  int64_t per_producer = tasks / producers;
+  Latch latch(per_producer * producers);
+
+  auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&pool, &latch, per_producer]() {
+      for (int64_t i = 0; i < per_producer; ++i) {
+        pool->post([&latch]() { latch.count_down(); });
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  latch.wait();
+
+  Result result;
+  result.benchmark = "empty";
+  result.pool = PoolTraits<Pool>::name();
+  result.producers = producers;
+  result.workers = pool->size();
+  result.tasks = per_producer * producers;
+  result.seconds = seconds_since(start);
+  return result;
+}
+
+template <class Pool>
+Result bench_latency(int workers, int64_t tasks) {
+  // 分批提交并等待，避免队列无限积压让延迟只反映排队长度
+  const int64_t kBatch = 64;
+  auto pool = PoolTraits<Pool>::make(workers);
+  std::vector<int64_t> latencies(tasks);
+
+  auto start = Clock::now();
+  for (int64_t first = 0; first < tasks; first += kBatch) {
+    int64_t last = std::min(tasks, first + kBatch);
+    Latch latch(last - first);
+    for (int64_t i = first; i < last; ++i) {
+      auto submit = Clock::now();
+      pool->post([&latencies, &latch, submit, i]() {
+        latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           Clock::now() - submit)
+                           .count();
+        latch.count_down();
+      });
+    }
+    latch.wait();
+  }
+
+  Result result;
+  result.benchmark = "latency";
+  result.pool = PoolTraits<Pool>::name();
+  result.producers = 1;
+  result.workers = pool->size();
+  result.tasks = tasks;
+  result.seconds = seconds_since(start);
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    size_t index = static_cast<size_t>(p / 100.0 * (latencies.size() - 1));
+    return latencies[index];
+  };
+  result.p50_ns = percentile(50);
+  result.p90_ns = percentile(90);
+  result.p99_ns = percentile(99);
+  result.p999_ns = percentile(99.9);
+  return result;
+}
+
+template <class Pool>
+void fanout_node(Pool &pool, Latch &latch, int depth) {
+  if (depth == 0) {
+    latch.count_down();
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    pool.post([&pool, &latch, depth]() { fanout_node(pool, latch, depth - 1); });
+  }
+}
+
+template <class Pool>
+Result bench_fanout(int workers, int depth) {
+  auto pool = PoolTraits<Pool>::make(workers);
+  int64_t leaves = int64_t(1) << depth;
+  Latch latch(leaves);
+
+  auto start = Clock::now();
+  pool->post([&pool, &latch, depth]() { fanout_node(*pool, latch, depth); });
+  latch.wait();
+
+  Result result;
+  result.benchmark = "fanout";
+  result.pool = PoolTraits<Pool>::name();
+  result.producers = 1;
+  result.workers = pool->size();
+  // 满二叉树的节点总数
+  result.tasks = 2 * leaves - 1;
+  result.seconds = seconds_since(start);
+  return result;
+}
+
+void print_header(bool json) {
+  if (!json) {
+    std::cout << "benchmark,pool,producers,workers,tasks,seconds,tasks_per_sec,"
+                 "p50_ns,p90_ns,p99_ns,p999_ns"
+              << std::endl;
+  }
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"pool\":\""
+              << r.pool << "\",\"producers\":" << r.producers
+              << ",\"workers\":" << r.workers << ",\"tasks\":" << r.tasks
+              << ",\"seconds\":" << r.seconds
+              << ",\"tasks_per_sec\":" << r.tasks_per_sec();
+    if (r.p50_ns >= 0) {
+      std::cout << ",\"p50_ns\":" << r.p50_ns << ",\"p90_ns\":" << r.p90_ns
+                << ",\"p99_ns\":" << r.p99_ns << ",\"p999_ns\":" << r.p999_ns;
+    }
+    std::cout << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.pool << "," << r.producers << ","
+              << r.workers << "," << r.tasks << "," << r.seconds << ","
+              << r.tasks_per_sec() << ",";
+    if (r.p50_ns >= 0) {
+      std::cout << r.p50_ns << "," << r.p90_ns << "," << r.p99_ns << ","
+                << r.p999_ns;
+    } else {
+      std::cout << ",,,";
+    }
+    std::cout << std::endl;
+  }
+}
+
+/**
+ * 1, 2, 4, ... 直到 max（包含 max）。
+ */
+std::vector<int> powers_of_two(int max) {
+  std::vector<int> counts;
+  for (int n = 1; n < max; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max);
+  return counts;
+}
+
+template <class Pool>
+void run_all(int max_threads, int64_t tasks, bool json) {
+  for (int workers : powers_of_two(max_threads)) {
+    for (int producers : powers_of_two(max_threads)) {
+      // 每个生产者至少提交一个任务
+      if (producers > tasks) {
+        break;
+      }
+      print(bench_empty<Pool>(producers, workers, tasks), json);
+    }
+  }
+  for (int workers : powers_of_two(max_threads)) {
+    print(bench_latency<Pool>(workers, std::min<int64_t>(tasks, 100000)),
+          json);
+  }
+  int depth = 1;
+  while ((int64_t(2) << depth) <= tasks) {
+    ++depth;
+  }
+  for (int workers : powers_of_two(max_threads)) {
+    print(bench_fanout<Pool>(workers, depth), json);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  int64_t tasks = 200000;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--max-threads=", 0) == 0) {
+      max_threads = std::max(1, std::stoi(arg.substr(14)));
+    } else if (arg.rfind("--tasks=", 0) == 0) {
+      tasks = std::max<int64_t>(1, std::stoll(arg.substr(8)));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--json] [--max-threads=N] [--tasks=N]" << std::endl;
+      return 1;
+    }
+  }
+
+  print_header(json);
+  run_all<ThreadPool>(max_threads, tasks, json);
+  run_all<WorkStealingThreadPool>(max_threads, tasks, json);
+}
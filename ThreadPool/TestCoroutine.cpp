@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coroutine.h"
+#include "threadpool_v1.h"
+
+CoroTask<int> add(ThreadPool &pool, int a, int b) {
+  co_await schedule_on(pool);
+  co_return a + b;
+}
+
+CoroTask<std::string> pipeline(ThreadPool &pool) {
+  co_await schedule_on(pool);
+  int x = co_await add(pool, 2, 9);
+  int y = co_await async_task(pool, [x]() { return x * 2; });
+  co_return std::to_string(y) + "!";
+}
+
+CoroTask<void> failing(ThreadPool &pool) {
+  co_await schedule_on(pool);
+  throw std::runtime_error("coroutine failed");
+}
+
+void test_pipeline(ThreadPool &pool) {
+  std::cout << "pipeline: " << sync_wait(pipeline(pool)) << std::endl;
+  try {
+    sync_wait(failing(pool));
+  } catch (const std::exception &e) {
+    std::cout << "exception: " << e.what() << std::endl;
+  }
+}
+
+/**
+ * 嵌套 co_await 的 CoroTask 结束时通过对称转移直接恢复等待者。
+ */
+CoroTask<int> countdown(int n) {
+  if (n == 0) {
+    co_return 0;
+  }
+  co_return 1 + co_await countdown(n - 1);
+}
+
+void test_deep_chain(ThreadPool &pool) {
+  auto outer = [](ThreadPool &pool) -> CoroTask<int> {
+    co_await schedule_on(pool);
+    co_return co_await countdown(1000);
+  };
+  std::cout << "deep chain: " << sync_wait(outer(pool)) << std::endl;
+}
+
+/**
+ * start_on 的第一次 post 就失败时，异常交给返回的 Future，而不是终止程序。
+ */
+void test_start_on_stopped() {
+  ThreadPool stopped(1);
+  stopped.drain();
+  Future<int> result = start_on(stopped, countdown(3));
+  try {
+    result.get();
+  } catch (const std::runtime_error &e) {
+    std::cout << "start_on stopped pool: " << e.what() << std::endl;
+  }
+}
+
+/**
+ * 单线程的线程池同时挂起上万个等待外部事件的协程。
+ * 如果用阻塞的 get() 等待，需要同样多的线程。
+ */
+CoroTask<int> wait_event(ThreadPool &pool, Future<int> event) {
+  co_await schedule_on(pool);
+  int value = co_await std::move(event);
+  co_return value + 1;
+}
+
+void test_in_flight(ThreadPool &pool, int n) {
+  std::vector<Promise<int>> events(n);
+  std::vector<Future<int>> results;
+  results.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    results.push_back(start_on(pool, wait_event(pool, events[i].get_future())));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&events, n]() {
+    for (int i = 0; i < n; ++i) {
+      events[i].set_value(i);
+    }
+  });
+  auto all = when_all(std::move(results)).get();
+  producer.join();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  long long sum = 0;
+  for (int x : all) {
+    sum += x;
+  }
+  std::cout << "in flight: " << n << " coroutines on " << pool.size()
+            << " thread(s), sum=" << sum << ", " << elapsed.count() << "us"
+            << std::endl;
+}
+
+int main() {
+  ThreadPool pool(1);
+  test_pipeline(pool);
+  test_deep_chain(pool);
+  test_start_on_stopped();
+  test_in_flight(pool, 10000);
+}
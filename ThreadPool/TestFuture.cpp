@@ -0,0 +1,162 @@
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "future.h"
+#include "threadpool_v1.h"
+
+void test_then(ThreadPool &pool) {
+  auto result = async_task(pool, [](int a, int b) { return a + b; }, 2, 9)
+                    .then(pool, [](int x) { return x * 2; })
+                    .then(pool, [](int x) { return std::to_string(x); })
+                    .then(pool, [](std::string s) { return s + "!"; });
+  std::cout << "then: " << result.get() << std::endl;
+
+  auto failed = async_task(pool, []() -> int {
+                  throw std::runtime_error("upstream failed");
+                }).then(pool, [](int x) { return x + 1; });
+  try {
+    failed.get();
+  } catch (const std::exception &e) {
+    std::cout << "then exception: " << e.what() << std::endl;
+  }
+}
+
+/**
+ * 单线程的线程池上串起很长的延续链，不会有线程因为等待上游而被阻塞。
+ */
+void test_long_chain(ThreadPool &pool) {
+  Future<int> f = async_task(pool, []() { return 0; });
+  for (int i = 0; i < 10000; ++i) {
+    f = f.then(pool, [](int x) { return x + 1; });
+  }
+  std::cout << "chain: " << f.get() << std::endl;
+}
+
+void test_when_all_any(ThreadPool &pool) {
+  std::vector<Future<int>> futures;
+  for (int i = 0; i < 10; ++i) {
+    futures.push_back(async_task(pool, [i]() { return i * i; }));
+  }
+  auto all = when_all(std::move(futures)).then(pool, [](std::vector<int> v) {
+    int sum = 0;
+    for (int x : v) {
+      sum += x;
+    }
+    return sum;
+  });
+  std::cout << "when_all: " << all.get() << std::endl;
+
+  std::vector<Future<void>> voids;
+  for (int i = 0; i < 3; ++i) {
+    voids.push_back(async_task(pool, []() {}));
+  }
+  when_all(std::move(voids)).get();
+
+  Promise<std::string> slow;
+  std::vector<Future<std::string>> candidates;
+  candidates.push_back(slow.get_future());
+  candidates.push_back(make_ready_future(std::string("fast")));
+  auto any = when_any(std::move(candidates)).get();
+  std::cout << "when_any: index=" << any.index << " value=" << any.value
+            << std::endl;
+  slow.set_value("slow");
+}
+
+/**
+ * 没有写入结果就被丢弃的 promise：Future 得到 broken_promise，而不是永远等待。
+ */
+void test_broken_promise(ThreadPool &pool) {
+  auto report = [](const char *name, auto &future) {
+    try {
+      future.get();
+      std::cout << name << ": no error" << std::endl;
+    } catch (const std::future_error &e) {
+      std::cout << name << ": " << e.what() << std::endl;
+    }
+  };
+
+  Future<int> dropped;
+  {
+    Promise<int> promise;
+    dropped = promise.get_future();
+  }
+  report("dropped promise", dropped);
+
+  // 任务在开始前被取消，持有 promise 的可调用对象直接析构
+  CancellationSource source;
+  source.cancel();
+  Promise<int> cancelled_promise;
+  Future<int> cancelled = cancelled_promise.get_future();
+  pool.post_cancellable(source.token(),
+                        [promise = std::move(cancelled_promise)]() mutable {
+                          promise.set_value(1);
+                        });
+  std::vector<Future<int>> inputs;
+  inputs.push_back(std::move(cancelled));
+  inputs.push_back(async_task(pool, []() { return 2; }));
+  auto all = when_all(std::move(inputs));
+  report("when_all with cancelled input", all);
+
+  // 延续投递到已经停止的线程池：post 抛出异常，set_from 不能再次写入已就绪的 promise
+  ThreadPool stopped(1);
+  stopped.drain();
+  Promise<int> upstream;
+  auto downstream =
+      upstream.get_future().then(stopped, [](int x) { return x + 1; });
+  upstream.set_from([]() { return 1; });
+  report("then on stopped pool", downstream);
+}
+
+void test_task_graph(ThreadPool &pool) {
+  // a -> b, a -> c, b -> d, c -> d
+  std::mutex mtx;
+  std::vector<std::string> order;
+  auto record = [&mtx, &order](const char *name) {
+    return [&mtx, &order, name]() {
+      std::unique_lock<std::mutex> locker(mtx);
+      order.emplace_back(name);
+    };
+  };
+
+  TaskGraph<ThreadPool> graph(pool);
+  auto a = graph.add(record("a"));
+  auto b = graph.add(record("b"));
+  auto c = graph.add(record("c"));
+  auto d = graph.add(record("d"));
+  graph.precede(a, b);
+  graph.precede(a, c);
+  graph.precede(b, d);
+  graph.precede(c, d);
+  graph.run().get();
+  graph.run().get();
+
+  std::cout << "graph:";
+  for (auto &name : order) {
+    std::cout << " " << name;
+  }
+  std::cout << std::endl;
+
+  TaskGraph<ThreadPool> cyclic(pool);
+  auto x = cyclic.add([]() {});
+  auto y = cyclic.add([]() {});
+  cyclic.precede(x, y);
+  cyclic.precede(y, x);
+  try {
+    cyclic.run();
+  } catch (const std::logic_error &e) {
+    std::cout << "graph: " << e.what() << std::endl;
+  }
+}
+
+int main() {
+  ThreadPool pool(1);
+  test_then(pool);
+  test_long_chain(pool);
+  test_when_all_any(pool);
+  test_broken_promise(pool);
+  test_task_graph(pool);
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parallel_algorithms.h"
+#include "threadpool_v1.h"
+
+template <typename F>
+double time_ms(F &&f) {
+  auto start_time = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_time;
+  return elapsed.count();
+}
+
+void report(const char *name, std::size_t n, double serial, double parallel,
+            bool ok) {
+  std::cout << name << " n=" << n << " serial: " << serial
+            << "ms parallel: " << parallel << "ms speedup: "
+            << serial / parallel << (ok ? "" : "  MISMATCH") << std::endl;
+}
+
+void bench_for(ThreadPool &pool, std::size_t n) {
+  std::vector<double> a(n, 1.0), b(n, 1.0);
+  double serial = time_ms([&]() {
+    std::for_each(a.begin(), a.end(), [](double &x) { x = std::sqrt(x + 1); });
+  });
+  double parallel = time_ms([&]() {
+    parallel_for(pool, std::size_t(0), n,
+                 [&b](std::size_t i) { b[i] = std::sqrt(b[i] + 1); });
+  });
+  report("parallel_for      ", n, serial, parallel, a == b);
+}
+
+void bench_reduce(ThreadPool &pool, std::size_t n) {
+  std::vector<long long> a(n);
+  std::iota(a.begin(), a.end(), 0);
+  long long s1 = 0, s2 = 0;
+  double serial =
+      time_ms([&]() { s1 = std::accumulate(a.begin(), a.end(), 0LL); });
+  double parallel =
+      time_ms([&]() { s2 = parallel_reduce(pool, a.begin(), a.end(), 0LL); });
+  report("parallel_reduce   ", n, serial, parallel, s1 == s2);
+}
+
+void bench_transform(ThreadPool &pool, std::size_t n) {
+  std::vector<float> in(n, 2.0f), out1(n), out2(n);
+  auto op = [](float x) { return x * x + 1.0f; };
+  double serial =
+      time_ms([&]() { std::transform(in.begin(), in.end(), out1.begin(), op); });
+  double parallel = time_ms([&]() {
+    parallel_transform(pool, in.begin(), in.end(), out2.begin(), op);
+  });
+  report("parallel_transform", n, serial, parallel, out1 == out2);
+}
+
+void bench_sort(ThreadPool &pool, std::size_t n) {
+  std::mt19937 rng(42);
+  std::vector<int> a(n);
+  for (auto &x : a) {
+    x = static_cast<int>(rng());
+  }
+  std::vector<int> b = a;
+  double serial = time_ms([&]() { std::sort(a.begin(), a.end()); });
+  double parallel = time_ms([&]() { parallel_sort(pool, b.begin(), b.end()); });
+  report("parallel_sort     ", n, serial, parallel, a == b);
+}
+
+void test_nested(ThreadPool &pool) {
+  std::vector<int> counts(64 * 64, 0);
+  parallel_for(pool, 0, 64, [&](int i) {
+    parallel_for(pool, 0, 64, [&](int j) { counts[i * 64 + j] += 1; });
+  });
+  bool ok = std::all_of(counts.begin(), counts.end(),
+                        [](int c) { return c == 1; });
+  std::cout << "nested parallel_for: " << (ok ? "ok" : "FAILED") << std::endl;
+}
+
+void test_exception(ThreadPool &pool) {
+  try {
+    parallel_for(pool, 0, 1000, [](int i) {
+      if (i == 500) {
+        throw std::runtime_error("index 500");
+      }
+    });
+    std::cout << "exception: FAILED" << std::endl;
+  } catch (const std::exception &e) {
+    std::cout << "exception: " << e.what() << std::endl;
+  }
+}
+
+/**
+ * 用法：TestParallelAlgorithms [n1 n2 ...]，默认 1M 和 10M，可传入 100000000。
+ */
+int main(int argc, char *argv[]) {
+  ThreadPool pool;
+  test_nested(pool);
+  test_exception(pool);
+
+  std::vector<std::size_t> sizes = {1000000, 10000000};
+  if (argc > 1) {
+    sizes.clear();
+    for (int i = 1; i < argc; ++i) {
+      sizes.push_back(std::stoull(argv[i]));
+    }
+  }
+  std::cout << "threads: " << pool.size() << std::endl;
+  for (std::size_t n : sizes) {
+    bench_for(pool, n);
+    bench_reduce(pool, n);
+    bench_transform(pool, n);
+    bench_sort(pool, n);
+  }
+}
@@ -1,8 +1,48 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include <sched.h>
+
+#define THREADPOOL_METRICS 1
 #include "threadpool_v1.h"
 
+// 统计全局分配次数，用于验证提交路径不访问全局分配器
+static std::atomic<long> g_allocations{0};
+
+void *operator new(std::size_t n) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(n == 0 ? 1 : n)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+// 不允许内联：否则 GCC 在调用处看到 operator new 的结果被 free，
+// 会误报 -Wmismatched-new-delete
+#if defined(__GNUC__)
+#define NO_INLINE __attribute__((noinline))
+#else
+#define NO_INLINE
+#endif
+
+NO_INLINE void operator delete(void *p) noexcept { std::free(p); }
+
+NO_INLINE void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
 int task1(int a, int b) { return a + b; }
 
 void test_threadpool() {
@@ -19,4 +59,524 @@ void test_threadpool() {
   std::cout << task3_ret.get() << std::endl;
 }
 
-int main() { test_threadpool(); }
\ No newline at end of file
+void test_allocation_free_commit() {
+  ThreadPool threadpool(2);
+  const int numTasks = 10000;
+  std::vector<std::future<int>> futures;
+  futures.reserve(2 * numTasks);
+
+  // 预热：先挡住工作线程，让 2 * numTasks 个任务同时排队，
+  // 任务队列的容量和内存池中的块数都超过正式测量时的峰值
+  // （工作线程的本地缓存里可能留着一些块，所以预热的数量要多出一些）
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  for (int i = 0; i < 2; ++i) {
+    threadpool.post([opened]() { opened.wait(); });
+  }
+  for (int i = 0; i < 2 * numTasks; ++i) {
+    futures.emplace_back(threadpool.commit_task(task1, i, 1));
+  }
+  gate.set_value();
+  for (auto &f : futures) {
+    f.get();
+  }
+  futures.clear();
+
+  long before = g_allocations.load();
+  for (int i = 0; i < numTasks; ++i) {
+    futures.emplace_back(threadpool.commit_task(task1, i, 1));
+  }
+  for (auto &f : futures) {
+    f.get();
+  }
+  long after = g_allocations.load();
+
+  std::cout << "allocations for " << numTasks
+            << " tasks: " << after - before << std::endl;
+  assert(after == before);
+}
+
+/**
+ * 线程退出时 thread_local 按构造的逆序析构：held 先于 BlockPool 的本地缓存构造，
+ * 所以析构时本地缓存已经不在了，释放共享状态的块要退回全局链表。
+ */
+void test_thread_exit_deallocate() {
+  ThreadPool threadpool(1);
+  std::thread t([&threadpool]() {
+    static thread_local std::future<int> held;
+    held = threadpool.commit_task(task1, 1, 2);
+    held.wait();
+  });
+  t.join();
+  std::cout << "future released after thread-local cache: ok" << std::endl;
+}
+
+/**
+ * 对齐要求超过 max_align_t 的可调用对象和返回值不能放在 BlockPool 的块里，
+ * 返回值放在共享状态中，错位时 UBSan 会报告。
+ */
+struct alignas(64) AlignedTask {
+  std::atomic<int> *misaligned;
+
+  void operator()() const {
+    if (reinterpret_cast<std::uintptr_t>(this) % 64 != 0) {
+      misaligned->fetch_add(1);
+    }
+  }
+};
+
+struct alignas(64) AlignedResult {
+  int value;
+};
+
+void test_over_aligned_task() {
+  ThreadPool threadpool(2);
+  std::atomic<int> misaligned{0};
+  std::vector<std::future<AlignedResult>> futures;
+  for (int i = 0; i < 100; ++i) {
+    threadpool.post(AlignedTask{&misaligned});
+    futures.push_back(threadpool.commit_task([i]() { return AlignedResult{i}; }));
+  }
+  int sum = 0;
+  for (auto &f : futures) {
+    sum += f.get().value;
+  }
+  threadpool.drain();
+  std::cout << "over-aligned tasks: misaligned = " << misaligned.load()
+            << ", sum = " << sum << std::endl;
+  assert(misaligned.load() == 0 && sum == 4950);
+}
+
+/**
+ * 分别统计提交（提交调用返回）和总时间（全部任务执行完）。
+ * 提交期间先挡住工作线程，提交时间只包含构造任务和入队的开销。
+ * name 为 nullptr 时只运行不输出。
+ */
+void test_post_and_bulk() {
+  ThreadPool threadpool(2);
+  const int numTasks = 100000;
+  std::vector<int> inputs(numTasks, 1);
+  std::atomic<int> sum{0};
+  auto add = [&sum](int v) { sum.fetch_add(v); };
+
+  auto measure = [&threadpool](const char *name, auto submit) {
+    using std::chrono::microseconds;
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    for (int i = 0; i < threadpool.size(); ++i) {
+      threadpool.post([opened]() { opened.wait(); });
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    auto wait_all = submit();
+    auto submit_time = std::chrono::steady_clock::now() - start_time;
+    gate.set_value();
+    wait_all();
+    threadpool.commit_task([]() {}).get();
+    auto total_time = std::chrono::steady_clock::now() - start_time;
+    if (name == nullptr) {
+      return;
+    }
+    std::cout << name << " x" << numTasks << ": submit "
+              << std::chrono::duration_cast<microseconds>(submit_time).count()
+              << "us, total "
+              << std::chrono::duration_cast<microseconds>(total_time).count()
+              << "us" << std::endl;
+  };
+
+  // 预热：让任务队列先增长到 numTasks 的容量
+  measure(nullptr, [&]() {
+    threadpool.post_bulk(inputs.begin(), inputs.end(), add);
+    return []() {};
+  });
+  measure("commit_task", [&]() {
+    auto futures = std::make_shared<std::vector<std::future<void>>>();
+    futures->reserve(numTasks);
+    for (int x : inputs) {
+      futures->emplace_back(threadpool.commit_task(add, x));
+    }
+    return [futures]() {
+      for (auto &f : *futures) {
+        f.get();
+      }
+    };
+  });
+  measure("commit_bulk", [&]() {
+    auto futures = std::make_shared<std::vector<std::future<void>>>(
+        threadpool.commit_bulk(inputs.begin(), inputs.end(), add));
+    return [futures]() {
+      for (auto &f : *futures) {
+        f.get();
+      }
+    };
+  });
+  measure("post       ", [&]() {
+    for (int x : inputs) {
+      threadpool.post(add, x);
+    }
+    return []() {};
+  });
+  measure("post_bulk  ", [&]() {
+    threadpool.post_bulk(inputs.begin(), inputs.end(), add);
+    return []() {};
+  });
+  std::cout << "sum = " << sum.load() << std::endl;
+}
+
+void print_priority_stats(ThreadPool &threadpool) {
+  const char *names[] = {"high", "normal", "background"};
+  for (int i = 0; i < kNumTaskPriorities; ++i) {
+    PriorityStats stats = threadpool.priority_stats(static_cast<TaskPriority>(i));
+    std::cout << "  " << names[i] << ": depth=" << stats.depth
+              << " submitted=" << stats.submitted
+              << " expired=" << stats.expired
+              << " wait p50=" << stats.wait.percentile_ns(50) / 1000
+              << "us p99=" << stats.wait.percentile_ns(99) / 1000 << "us"
+              << std::endl;
+  }
+}
+
+void test_priority() {
+  ThreadPool threadpool(1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  threadpool.post([opened]() { opened.wait(); });
+
+  std::mutex mtx;
+  std::vector<std::string> order;
+  auto record = [&mtx, &order](const char *name) {
+    std::unique_lock<std::mutex> locker(mtx);
+    order.emplace_back(name);
+  };
+  for (int i = 0; i < 3; ++i) {
+    threadpool.post(TaskPriority::kBackground, record, "background");
+    threadpool.post(TaskPriority::kNormal, record, "normal");
+    threadpool.post(TaskPriority::kHigh, record, "high");
+  }
+  auto expired = threadpool.commit_task_until(
+      TaskPriority::kHigh, ThreadPool::Clock::now(), []() { return 1; });
+  auto urgent = threadpool.commit_task_until(
+      TaskPriority::kNormal,
+      ThreadPool::Clock::now() + std::chrono::seconds(10),
+      []() { return 2; });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  gate.set_value();
+
+  std::cout << "urgent = " << urgent.get() << std::endl;
+  try {
+    expired.get();
+    std::cout << "expired task ran" << std::endl;
+  } catch (const std::future_error &e) {
+    std::cout << "expired task dropped: " << e.what() << std::endl;
+  }
+  threadpool.commit_task(TaskPriority::kBackground, []() {}).get();
+
+  std::cout << "order:";
+  for (auto &name : order) {
+    std::cout << " " << name;
+  }
+  std::cout << std::endl;
+  print_priority_stats(threadpool);
+}
+
+/**
+ * 同一优先级的截止时间任务源源不断时，普通 FIFO 任务仍然能执行：
+ * 每个截止时间任务执行时再提交一个，FIFO 任务最多被跳过 kFifoStarvationLimit 次。
+ */
+struct DeadlineStream {
+  ThreadPool *pool;
+  std::atomic<bool> *fifo_done;
+  std::atomic<int> *ran;
+
+  void operator()() const {
+    ran->fetch_add(1);
+    if (!fifo_done->load() && ran->load() < 2000) {
+      pool->commit_task_until(TaskPriority::kNormal,
+                              ThreadPool::Clock::now() + std::chrono::seconds(10),
+                              *this);
+    }
+  }
+};
+
+void test_deadline_fifo_fairness() {
+  ThreadPool threadpool(1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  // 挡住工作线程的任务本身也在 FIFO 里，等它开始执行后再提交
+  std::promise<void> blocked;
+  threadpool.post([opened, &blocked]() {
+    blocked.set_value();
+    opened.wait();
+  });
+  blocked.get_future().wait();
+
+  std::atomic<bool> fifo_done{false};
+  std::atomic<int> ran{0};
+  for (int i = 0; i < 4; ++i) {
+    threadpool.commit_task_until(
+        TaskPriority::kNormal,
+        ThreadPool::Clock::now() + std::chrono::seconds(10),
+        DeadlineStream{&threadpool, &fifo_done, &ran});
+  }
+  int ran_before = -1;
+  auto fifo = threadpool.commit_task(TaskPriority::kNormal, [&]() {
+    ran_before = ran.load();
+    fifo_done = true;
+  });
+  gate.set_value();
+  fifo.get();
+  threadpool.drain();
+  std::cout << "deadline tasks before fifo task: " << ran_before << std::endl;
+  assert(ran_before == PriorityTaskQueue::kFifoStarvationLimit);
+}
+
+/**
+ * 后台任务持续占满线程池时，比较高优先级和普通任务的等待时间。
+ */
+void test_priority_latency() {
+  ThreadPool threadpool;
+  auto busy = []() {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+  };
+  for (int i = 0; i < 4000; ++i) {
+    threadpool.post(TaskPriority::kBackground, busy);
+    if (i % 20 == 0) {
+      threadpool.post(TaskPriority::kHigh, []() {});
+      threadpool.post(TaskPriority::kNormal, []() {});
+    }
+  }
+  threadpool.commit_task(TaskPriority::kBackground, []() {}).get();
+  std::cout << "latency under background load:" << std::endl;
+  print_priority_stats(threadpool);
+}
+
+void test_resize() {
+  ThreadPoolOptions options;
+  options.min_threads = 1;
+  options.max_threads = 8;
+  options.idle_timeout = std::chrono::milliseconds(50);
+  ThreadPool threadpool(options);
+  std::cout << "initial size: " << threadpool.size() << std::endl;
+
+  // 模拟 I/O 密集的任务，积压后线程池应自动扩容
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 200; ++i) {
+    futures.emplace_back(threadpool.commit_task([]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }));
+  }
+  int peak = 0;
+  for (auto &f : futures) {
+    peak = std::max(peak, threadpool.size());
+    f.get();
+  }
+  std::cout << "peak size under backlog: " << peak << std::endl;
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  std::cout << "size after idle: " << threadpool.size() << std::endl;
+
+  threadpool.resize(4);
+  std::cout << "size after resize(4): " << threadpool.size() << std::endl;
+  threadpool.resize(2);
+  threadpool.commit_task([]() {}).get();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::cout << "size after resize(2): " << threadpool.size() << std::endl;
+}
+
+/**
+ * 队列里还有积压时析构：工作线程取任务后会尝试扩容，析构开始后不能再创建线程，
+ * 否则新线程不会被 join。
+ */
+void test_destroy_while_growing() {
+  for (int round = 0; round < 10; ++round) {
+    ThreadPoolOptions options;
+    options.min_threads = 1;
+    options.max_threads = 64;
+    options.spawn_interval = std::chrono::microseconds(500);
+    ThreadPool threadpool(options);
+    for (int i = 0; i < 200; ++i) {
+      threadpool.post([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      });
+    }
+  }
+  std::cout << "destroyed with backlog: ok" << std::endl;
+}
+
+void test_affinity() {
+  auto cpus = parse_cpu_list("0-3, 8,10-11");
+  std::cout << "parse_cpu_list:";
+  for (int cpu : cpus) {
+    std::cout << " " << cpu;
+  }
+  std::cout << std::endl;
+
+  auto topology = CpuTopology::detect();
+  std::cout << "numa nodes: " << topology.num_nodes() << std::endl;
+
+  ThreadPoolOptions options;
+  options.min_threads = options.max_threads = 4;
+  options.numa_aware = true;
+  options.pin_per_core = true;
+  ThreadPool threadpool(options);
+
+  // 每个节点上提交的任务记录自己运行在哪个 CPU 上
+  std::mutex mtx;
+  std::set<int> used;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 100; ++i) {
+    futures.emplace_back(threadpool.commit_task_on(i, [&mtx, &used]() {
+      std::unique_lock<std::mutex> locker(mtx);
+      used.insert(sched_getcpu());
+    }));
+  }
+  for (auto &f : futures) {
+    f.get();
+  }
+  std::cout << "pool nodes: " << threadpool.num_nodes() << ", cpus used:";
+  for (int cpu : used) {
+    std::cout << " " << cpu;
+  }
+  std::cout << std::endl;
+}
+
+void test_metrics() {
+  ThreadPool threadpool(2);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 1000; ++i) {
+    futures.emplace_back(threadpool.commit_task([i]() {
+      if (i % 100 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }));
+  }
+  for (auto &f : futures) {
+    f.get();
+  }
+
+  ThreadPoolMetrics metrics = threadpool.metrics();
+  std::cout << "metrics: enabled=" << metrics.enabled
+            << " depth=" << metrics.queue_depth
+            << " completed=" << metrics.completed
+            << " wakeups=" << metrics.wakeups << " steals=" << metrics.steals
+            << std::endl;
+  std::cout << "  wait p50=" << metrics.wait.percentile_ns(50) / 1000
+            << "us p99=" << metrics.wait.percentile_ns(99) / 1000 << "us"
+            << ", run p50=" << metrics.run.percentile_ns(50)
+            << "ns p99=" << metrics.run.percentile_ns(99) / 1000 << "us"
+            << std::endl;
+  for (auto &worker : metrics.workers) {
+    std::cout << "  worker " << worker.id << ": tasks=" << worker.tasks
+              << " busy=" << worker.busy_ratio() * 100 << "%" << std::endl;
+  }
+}
+
+void test_backpressure() {
+  // 单线程、队列上限 4：第一个任务阻塞住工作线程，观察队列满时的三种策略
+  for (auto policy : {QueueFullPolicy::kReject, QueueFullPolicy::kCallerRuns,
+                      QueueFullPolicy::kBlock}) {
+    ThreadPoolOptions options;
+    options.min_threads = options.max_threads = 1;
+    options.max_queue_size = 4;
+    options.full_policy = policy;
+    ThreadPool threadpool(options);
+
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    threadpool.post([opened]() { opened.wait(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::atomic<int> in_caller{0};
+    int rejected = 0;
+    auto caller = std::this_thread::get_id();
+    std::thread opener([&gate]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      gate.set_value();
+    });
+    for (int i = 0; i < 10; ++i) {
+      try {
+        threadpool.post([&in_caller, caller]() {
+          if (std::this_thread::get_id() == caller) {
+            ++in_caller;
+          }
+        });
+      } catch (const QueueFullError &) {
+        ++rejected;
+      }
+    }
+    opener.join();
+    threadpool.drain();
+    const char *names[] = {"block", "reject", "caller-runs"};
+    std::cout << "queue full, " << names[static_cast<int>(policy)]
+              << ": rejected=" << rejected << " ran in caller=" << in_caller
+              << std::endl;
+  }
+}
+
+void test_cancellation_and_shutdown() {
+  ThreadPool threadpool(1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  threadpool.post([opened]() { opened.wait(); });
+
+  CancellationSource source;
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 10; ++i) {
+    futures.emplace_back(
+        threadpool.commit_cancellable(source.token(), [i]() { return i; }));
+  }
+  source.cancel();
+  gate.set_value();
+  int broken = 0;
+  for (auto &f : futures) {
+    try {
+      f.get();
+    } catch (const std::future_error &) {
+      ++broken;
+    }
+  }
+  std::cout << "cancelled: " << broken << ", stats: "
+            << threadpool.priority_stats(TaskPriority::kNormal).cancelled
+            << std::endl;
+
+  // shutdown_now 丢弃排队中的任务，之后不能再提交
+  std::promise<void> gate2;
+  std::shared_future<void> opened2 = gate2.get_future().share();
+  threadpool.post([opened2]() { opened2.wait(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::vector<std::future<void>> pending;
+  for (int i = 0; i < 5; ++i) {
+    pending.emplace_back(threadpool.commit_task([]() {}));
+  }
+  std::thread opener([&gate2]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate2.set_value();
+  });
+  size_t discarded = threadpool.shutdown_now();
+  opener.join();
+  std::cout << "shutdown_now discarded: " << discarded << std::endl;
+  try {
+    threadpool.commit_task([]() {});
+  } catch (const std::runtime_error &e) {
+    std::cout << "after shutdown: " << e.what() << std::endl;
+  }
+}
+
+int main() {
+  test_threadpool();
+  test_allocation_free_commit();
+  test_thread_exit_deallocate();
+  test_over_aligned_task();
+  test_post_and_bulk();
+  test_priority();
+  test_deadline_fifo_fairness();
+  test_priority_latency();
+  test_resize();
+  test_destroy_while_growing();
+  test_affinity();
+  test_metrics();
+  test_backpressure();
+  test_cancellation_and_shutdown();
+}
@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "threadpool_v1.h"
+#include "threadpool_v2.h"
+
+int task1(int a, int b) { return a + b; }
+
+void test_threadpool() {
+  WorkStealingThreadPool threadpool(2);
+  auto task1_ret = threadpool.commit_task(task1, 2, 9);
+  auto task2_ret = threadpool.commit_task(
+      [](int a, int b) -> int { return std::pow(a, b); }, 2, 9);
+
+  auto lambda_func = [](int a) -> int { return std::sqrt(a); };
+  auto task3_ret = threadpool.commit_task(lambda_func, 9);
+
+  std::cout << task1_ret.get() << std::endl;
+  std::cout << task2_ret.get() << std::endl;
+  std::cout << task3_ret.get() << std::endl;
+
+  // 超过一批（kBulkBatch）的批量提交
+  std::vector<int> inputs(1000);
+  for (int i = 0; i < 1000; ++i) {
+    inputs[i] = i;
+  }
+  auto squares = threadpool.commit_bulk(inputs.begin(), inputs.end(),
+                                        [](int x) { return x * x; });
+  long sum = 0;
+  for (auto &f : squares) {
+    sum += f.get();
+  }
+  std::atomic<int> posted{0};
+  threadpool.post_bulk(inputs.begin(), inputs.end(),
+                       [&posted](int) { posted.fetch_add(1); });
+  while (posted.load() < 1000) {
+    std::this_thread::yield();
+  }
+  std::cout << "commit_bulk sum of squares = " << sum
+            << ", post_bulk ran = " << posted.load() << std::endl;
+}
+
+/**
+ * 外部线程提交大量空任务，统计吞吐量（tasks/s）。
+ */
+template <typename Pool>
+double external_submit_throughput(int numThreads, int numTasks) {
+  Pool pool(numThreads);
+  std::vector<std::future<void>> futures;
+  futures.reserve(numTasks);
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int i = 0; i < numTasks; ++i) {
+    futures.emplace_back(pool.commit_task([]() {}));
+  }
+  for (auto &f : futures) {
+    f.get();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start_time;
+  return numTasks / elapsed.count();
+}
+
+/**
+ * 每个根任务在工作线程内部再提交若干子任务，模拟递归拆分的场景。
+ */
+template <typename Pool>
+double nested_submit_throughput(int numThreads, int numRoots, int fanout) {
+  Pool pool(numThreads);
+  std::atomic<int> done{0};
+  std::vector<std::future<void>> roots;
+  roots.reserve(numRoots);
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int i = 0; i < numRoots; ++i) {
+    roots.emplace_back(pool.commit_task([&pool, &done, fanout]() {
+      for (int j = 0; j < fanout; ++j) {
+        pool.commit_task([&done]() { done.fetch_add(1); });
+      }
+    }));
+  }
+  for (auto &f : roots) {
+    f.get();
+  }
+  while (done.load() < numRoots * fanout) {
+    std::this_thread::yield();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start_time;
+  return numRoots * (fanout + 1) / elapsed.count();
+}
+
+void compare_throughput(int numThreads) {
+  const int numTasks = 200000;
+  const int numRoots = 2000;
+  const int fanout = 100;
+
+  std::cout << "threads: " << numThreads << std::endl;
+  std::cout << "  external ThreadPool:             "
+            << external_submit_throughput<ThreadPool>(numThreads, numTasks)
+            << " tasks/s" << std::endl;
+  std::cout << "  external WorkStealingThreadPool: "
+            << external_submit_throughput<WorkStealingThreadPool>(numThreads,
+                                                                  numTasks)
+            << " tasks/s" << std::endl;
+  std::cout << "  nested   ThreadPool:             "
+            << nested_submit_throughput<ThreadPool>(numThreads, numRoots,
+                                                    fanout)
+            << " tasks/s" << std::endl;
+  std::cout << "  nested   WorkStealingThreadPool: "
+            << nested_submit_throughput<WorkStealingThreadPool>(
+                   numThreads, numRoots, fanout)
+            << " tasks/s" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  test_threadpool();
+
+  int numThreads = std::thread::hardware_concurrency();
+  if (argc > 1) {
+    numThreads = std::stoi(argv[1]);
+  }
+  compare_throughput(numThreads);
+}
@@ -0,0 +1,141 @@
+#ifndef THREAD_POOL_AFFINITY_H
+#define THREAD_POOL_AFFINITY_H
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/**
+ * 解析 Linux 的 CPU 列表格式，例如 "0-3,8,10-11"。非法的部分被忽略。
+ */
+inline std::vector<int> parse_cpu_list(const std::string &text) {
+  std::vector<int> cpus;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find(',', pos);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    std::string item = text.substr(pos, end - pos);
+    item.erase(std::remove_if(item.begin(), item.end(),
+                              [](unsigned char c) { return std::isspace(c); }),
+               item.end());
+    pos = end + 1;
+    if (item.empty() || !std::isdigit(static_cast<unsigned char>(item[0]))) {
+      continue;
+    }
+    size_t dash = item.find('-');
+    int first = std::stoi(item.substr(0, dash));
+    int last = first;
+    if (dash != std::string::npos && dash + 1 < item.size()) {
+      last = std::stoi(item.substr(dash + 1));
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+/**
+ * 当前进程允许使用的 CPU（受 taskset、cgroup cpuset 等限制）。
+ */
+inline std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int n = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < n; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/**
+ * 把调用线程绑定到 cpus 上。不支持或失败时返回 false，线程保持原来的亲和性。
+ */
+inline bool set_thread_affinity(const std::vector<int> &cpus) {
+#if defined(__linux__)
+  if (cpus.empty()) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+/**
+ * NUMA 拓扑：每个节点上当前进程可用的 CPU。
+ * 从 /sys/devices/system/node 读取，读取失败或不是 Linux 时视为只有一个节点。
+ */
+struct CpuTopology {
+  std::vector<std::vector<int>> nodes;
+
+  int num_nodes() const { return static_cast<int>(nodes.size()); }
+
+  /**
+   * 探测拓扑。only 非空时只保留其中的 CPU，结果中不包含空节点。
+   */
+  static CpuTopology detect(const std::vector<int> &only = {}) {
+    std::vector<int> allowed = only.empty() ? allowed_cpus() : only;
+    std::sort(allowed.begin(), allowed.end());
+
+    CpuTopology topology;
+    const std::string root = "/sys/devices/system/node/";
+    for (int node : parse_cpu_list(read_line(root + "online"))) {
+      std::vector<int> cpus;
+      for (int cpu : parse_cpu_list(
+               read_line(root + "node" + std::to_string(node) + "/cpulist"))) {
+        if (std::binary_search(allowed.begin(), allowed.end(), cpu)) {
+          cpus.push_back(cpu);
+        }
+      }
+      if (!cpus.empty()) {
+        topology.nodes.push_back(std::move(cpus));
+      }
+    }
+    if (topology.nodes.empty()) {
+      topology.nodes.push_back(allowed);
+    }
+    return topology;
+  }
+
+ private:
+  static std::string read_line(const std::string &path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+};
+
+#endif /* THREAD_POOL_AFFINITY_H */
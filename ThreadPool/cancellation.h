@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_CANCELLATION_H
+#define THREAD_POOL_CANCELLATION_H
+
+#include <atomic>
+#include <memory>
+
+class CancellationSource;
+
+/**
+ * 协作式取消的令牌，可以随任务一起复制。
+ * 默认构造的令牌永远不会被取消，检查它不需要任何原子操作。
+ */
+class CancellationToken {
+ public:
+  CancellationToken() = default;
+
+  bool cancelled() const {
+    return state_ && state_->load(std::memory_order_acquire);
+  }
+
+  bool can_be_cancelled() const { return state_ != nullptr; }
+
+ private:
+  friend class CancellationSource;
+
+  explicit CancellationToken(std::shared_ptr<std::atomic<bool>> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<std::atomic<bool>> state_;
+};
+
+/**
+ * 发出取消请求的一方。cancel 之后，从它得到的所有令牌都变为已取消。
+ */
+class CancellationSource {
+ public:
+  CancellationSource() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  CancellationToken token() const { return CancellationToken(state_); }
+
+  void cancel() { state_->store(true, std::memory_order_release); }
+
+  bool cancelled() const { return state_->load(std::memory_order_acquire); }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> state_;
+};
+
+#endif /* THREAD_POOL_CANCELLATION_H */
@@ -0,0 +1,339 @@
+#ifndef THREAD_POOL_COROUTINE_H
+#define THREAD_POOL_COROUTINE_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "future.h"
+
+/**
+ * 基于 C++20 协程的线程池执行器（需要 -std=c++20）。
+ *
+ *  - CoroTask<T>：惰性启动的协程，被 co_await 时才开始执行，结束后对称转移回等待者；
+ *  - co_await schedule_on(pool)：把当前协程切换到 pool 的工作线程上继续执行；
+ *  - co_await future：等待 future.h 中的 Future，未就绪时挂起而不是阻塞线程，
+ *    由完成该 Future 的线程恢复协程；
+ *  - sync_wait(task)：在非工作线程中阻塞等待一个 CoroTask 完成。
+ *
+ * 协程挂起时不占用任何线程，一个线程池可以同时承载大量进行中的操作。
+ * Pool 只需要提供 post()。
+ */
+
+template <class T = void>
+class CoroTask;
+
+namespace detail {
+
+template <class T>
+class CoroPromiseBase {
+ public:
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> h) noexcept {
+      auto continuation = h.promise().continuation_;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { error_ = std::current_exception(); }
+
+  void set_continuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+
+ protected:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr error_;
+};
+
+template <class T>
+class CoroPromise : public CoroPromiseBase<T> {
+ public:
+  CoroTask<T> get_return_object();
+
+  template <class U>
+  void return_value(U &&value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T result() {
+    if (this->error_) {
+      std::rethrow_exception(this->error_);
+    }
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class CoroPromise<void> : public CoroPromiseBase<void> {
+ public:
+  CoroTask<void> get_return_object();
+
+  void return_void() {}
+
+  void result() {
+    if (this->error_) {
+      std::rethrow_exception(this->error_);
+    }
+  }
+};
+
+}  // namespace detail
+
+template <class T>
+class CoroTask {
+ public:
+  using promise_type = detail::CoroPromise<T>;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  CoroTask() = default;
+
+  explicit CoroTask(handle_type handle) : handle_(handle) {}
+
+  CoroTask(CoroTask &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+
+  CoroTask &operator=(CoroTask &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  CoroTask(const CoroTask &) = delete;
+  CoroTask &operator=(const CoroTask &) = delete;
+
+  ~CoroTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      handle_type handle;
+
+      bool await_ready() noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().set_continuation(awaiting);
+        return handle;
+      }
+
+      T await_resume() { return handle.promise().result(); }
+    };
+    return Awaiter{handle_};
+  }
+
+ private:
+  handle_type handle_;
+};
+
+/**
+ * co_await schedule_on(pool) 之后，协程在 pool 的工作线程上继续执行。
+ */
+template <class Pool>
+auto schedule_on(Pool &pool) {
+  struct Awaiter {
+    Pool &pool;
+
+    bool await_ready() noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+      pool.post([h]() { h.resume(); });
+    }
+
+    void await_resume() noexcept {}
+  };
+  return Awaiter{pool};
+}
+
+namespace detail {
+
+template <class T>
+CoroTask<T> CoroPromise<T>::get_return_object() {
+  return CoroTask<T>(std::coroutine_handle<CoroPromise<T>>::from_promise(*this));
+}
+
+inline CoroTask<void> CoroPromise<void>::get_return_object() {
+  return CoroTask<void>(
+      std::coroutine_handle<CoroPromise<void>>::from_promise(*this));
+}
+
+/**
+ * 立即开始、结束后自动销毁的协程，sync_wait 和 start_on 用它驱动 CoroTask。
+ */
+struct DetachedCoroutine {
+  struct promise_type {
+    DetachedCoroutine get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+class SyncWaitEvent {
+ public:
+  void set() {
+    std::unique_lock<std::mutex> locker(mtx_);
+    done_ = true;
+    cv_.notify_all();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> locker(mtx_);
+    cv_.wait(locker, [this]() { return done_; });
+  }
+
+ private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool done_ = false;
+};
+
+template <class T>
+DetachedCoroutine sync_wait_driver(CoroTask<T> &task,
+                                   std::optional<StorageType<T>> &result,
+                                   std::exception_ptr &error,
+                                   SyncWaitEvent &event) {
+  try {
+    if constexpr (std::is_void<T>::value) {
+      co_await std::move(task);
+      result.emplace();
+    } else {
+      result.emplace(co_await std::move(task));
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  event.set();
+}
+
+template <class Pool, class T>
+DetachedCoroutine start_on_driver(Pool &pool, CoroTask<T> task,
+                                  Promise<T> promise) {
+  std::optional<StorageType<T>> result;
+  std::exception_ptr error;
+  try {
+    // post 可能抛出（队列已满且策略为 kReject、线程池已停止），异常同样交给 Future
+    co_await schedule_on(pool);
+    if constexpr (std::is_void<T>::value) {
+      co_await std::move(task);
+      result.emplace();
+    } else {
+      result.emplace(co_await std::move(task));
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // set_from 不会把延续回调中的异常抛到这里，协程不会走到 unhandled_exception
+  promise.set_from([&]() -> T {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void<T>::value) {
+      return std::move(*result);
+    }
+  });
+}
+
+}  // namespace detail
+
+/**
+ * 在 pool 中启动 task 而不等待它，通过返回的 Future 获取结果，
+ * 可以和 then/when_all 组合。
+ */
+template <class Pool, class T>
+Future<T> start_on(Pool &pool, CoroTask<T> task) {
+  Promise<T> promise;
+  Future<T> ret = promise.get_future();
+  detail::start_on_driver(pool, std::move(task), std::move(promise));
+  return ret;
+}
+
+/**
+ * 等待 Future<T>：已就绪时不挂起，否则在完成它的线程上恢复协程。
+ */
+template <class T>
+auto operator co_await(Future<T> future) {
+  struct Awaiter {
+    Future<T> future;
+    std::optional<detail::StorageType<T>> value;
+    std::exception_ptr error;
+
+    bool await_ready() { return future.ready(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+      // 回调可能立即在当前线程恢复协程，之后不能再访问 this
+      future.on_complete([this, h](detail::FutureState<T> &state) {
+        try {
+          value.emplace(state.take());
+        } catch (...) {
+          error = std::current_exception();
+        }
+        h.resume();
+      });
+    }
+
+    T await_resume() {
+      if (future.valid()) {
+        // 没有挂起，直接取结果
+        if constexpr (std::is_void<T>::value) {
+          future.get();
+          return;
+        } else {
+          return future.get();
+        }
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      if constexpr (!std::is_void<T>::value) {
+        return std::move(*value);
+      }
+    }
+  };
+  return Awaiter{std::move(future), std::nullopt, nullptr};
+}
+
+/**
+ * 阻塞当前线程直到 task 完成，返回其结果或重新抛出其异常。
+ * 不要在线程池的工作线程中调用。
+ */
+template <class T>
+T sync_wait(CoroTask<T> task) {
+  std::optional<detail::StorageType<T>> result;
+  std::exception_ptr error;
+  detail::SyncWaitEvent event;
+  detail::sync_wait_driver(task, result, error, event);
+  event.wait();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  if constexpr (!std::is_void<T>::value) {
+    return std::move(*result);
+  }
+}
+
+#endif /* THREAD_POOL_COROUTINE_H */
@@ -0,0 +1,553 @@
+#ifndef THREAD_POOL_FUTURE_H
+#define THREAD_POOL_FUTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "task.h"
+
+/**
+ * 支持延续（then）的 Future/Promise，以及 when_all、when_any 和 TaskGraph。
+ *
+ * std::future 只能阻塞等待，在工作线程里对上游任务调用 get() 会占住线程甚至死锁。
+ * 这里的 Future 在结果就绪时回调已注册的延续，延续被投递到线程池执行，
+ * 整条流水线上没有任何工作线程被阻塞。Future 只能移动，结果只能被消费一次。
+ * Pool 只需要提供 post()。
+ */
+
+template <class T>
+class Future;
+
+template <class T>
+class Promise;
+
+namespace detail {
+
+struct Unit {};
+
+template <class T>
+using StorageType = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+template <class T>
+class FutureState {
+ public:
+  using Value = StorageType<T>;
+
+  void set_value(Value value) {
+    complete([&]() { value_.emplace(std::move(value)); });
+  }
+
+  void set_exception(std::exception_ptr error) {
+    complete([&]() { error_ = std::move(error); });
+  }
+
+  /**
+   * 尚未就绪时写入异常并返回 true，已经就绪时什么也不做。
+   */
+  bool try_set_exception(std::exception_ptr error) {
+    return try_complete([&]() { error_ = std::move(error); });
+  }
+
+  bool ready() const {
+    std::unique_lock<std::mutex> locker(mtx_);
+    return ready_;
+  }
+
+  void wait() const {
+    std::unique_lock<std::mutex> locker(mtx_);
+    cv_.wait(locker, [this]() { return ready_; });
+  }
+
+  /**
+   * 注册就绪后的回调，已就绪时在当前线程立即调用。只能注册一个。
+   */
+  void on_complete(MoveOnlyTask callback) {
+    {
+      std::unique_lock<std::mutex> locker(mtx_);
+      if (!ready_) {
+        callback_ = std::move(callback);
+        return;
+      }
+    }
+    callback();
+  }
+
+  /**
+   * 取走结果，调用前必须已经就绪。
+   */
+  Value take() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return std::move(*value_);
+  }
+
+ private:
+  template <class Setter>
+  void complete(Setter &&setter) {
+    if (!try_complete(std::forward<Setter>(setter))) {
+      throw std::logic_error("promise already satisfied");
+    }
+  }
+
+  template <class Setter>
+  bool try_complete(Setter &&setter) {
+    MoveOnlyTask callback;
+    {
+      std::unique_lock<std::mutex> locker(mtx_);
+      if (ready_) {
+        return false;
+      }
+      setter();
+      ready_ = true;
+      callback = std::move(callback_);
+    }
+    cv_.notify_all();
+    if (callback) {
+      callback();
+    }
+    return true;
+  }
+
+  mutable std::mutex mtx_;
+  mutable std::condition_variable cv_;
+  bool ready_ = false;
+  std::optional<Value> value_;
+  std::exception_ptr error_;
+  MoveOnlyTask callback_;
+};
+
+template <class F, class V>
+decltype(auto) invoke_with_value(F &f, V &&value) {
+  if constexpr (std::is_same<std::decay_t<V>, Unit>::value) {
+    return f();
+  } else {
+    return f(std::forward<V>(value));
+  }
+}
+
+template <class F, class T>
+using ContinuationResult = decltype(invoke_with_value(
+    std::declval<F &>(), std::declval<StorageType<T>>()));
+
+}  // namespace detail
+
+template <class T>
+class Promise {
+ public:
+  Promise()
+      : state_(std::allocate_shared<detail::FutureState<T>>(
+            PoolAllocator<detail::FutureState<T>>())) {}
+
+  Promise(Promise &&) noexcept = default;
+
+  Promise &operator=(Promise &&other) noexcept {
+    if (this != &other) {
+      abandon();
+      state_ = std::move(other.state_);
+    }
+    return *this;
+  }
+
+  /**
+   * 没有写入结果就析构时（例如任务被取消、过期、被 shutdown_now 丢弃，
+   * 或者投递延续时 post 抛出异常），Future 得到 std::future_error（broken_promise），
+   * 等待它的 get()、co_await 和 when_all 不会永远挂起。
+   */
+  ~Promise() { abandon(); }
+
+  Promise(const Promise &) = delete;
+  Promise &operator=(const Promise &) = delete;
+
+  Future<T> get_future() { return Future<T>(state_); }
+
+  template <class U = T, class = std::enable_if_t<!std::is_void<U>::value>>
+  void set_value(U value) {
+    state_->set_value(std::move(value));
+  }
+
+  template <class U = T, class = std::enable_if_t<std::is_void<U>::value>>
+  void set_value() {
+    state_->set_value(detail::Unit{});
+  }
+
+  void set_exception(std::exception_ptr error) {
+    state_->set_exception(std::move(error));
+  }
+
+  /**
+   * 调用 fn() 并把返回值或异常写入 promise。
+   */
+  template <class F>
+  void set_from(F &&fn) {
+    try {
+      if constexpr (std::is_void<T>::value) {
+        fn();
+        set_value();
+      } else {
+        set_value(fn());
+      }
+    } catch (...) {
+      // 异常也可能来自结果写入之后执行的延续回调（例如其中的 post 抛出），
+      // 此时 promise 已经就绪，不能再写入
+      state_->try_set_exception(std::current_exception());
+    }
+  }
+
+ private:
+  void abandon() noexcept {
+    if (state_ == nullptr) {
+      return;
+    }
+    try {
+      state_->try_set_exception(std::make_exception_ptr(
+          std::future_error(std::future_errc::broken_promise)));
+    } catch (...) {
+      // 延续回调中的异常无法传给任何人，回调自己持有的 promise 析构时会继续传递
+    }
+    state_.reset();
+  }
+
+  std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+template <class T>
+class Future {
+ public:
+  Future() = default;
+
+  bool valid() const { return state_ != nullptr; }
+
+  bool ready() const { return state_->ready(); }
+
+  void wait() const { state_->wait(); }
+
+  /**
+   * 阻塞等待并取走结果。不要在线程池的工作线程中调用，应使用 then。
+   */
+  T get() {
+    state_->wait();
+    auto state = std::move(state_);
+    if constexpr (std::is_void<T>::value) {
+      state->take();
+    } else {
+      return state->take();
+    }
+  }
+
+  /**
+   * 结果就绪后在 pool 中执行 f(value)（T 为 void 时执行 f()），返回 f 结果的 Future。
+   * 上游失败时跳过 f，异常传递给返回的 Future。
+   */
+  template <class Pool, class F>
+  auto then(Pool &pool, F &&f) -> Future<detail::ContinuationResult<F, T>> {
+    using R = detail::ContinuationResult<F, T>;
+    Promise<R> promise;
+    Future<R> ret = promise.get_future();
+    auto state = std::move(state_);
+    state->on_complete(
+        [&pool, state, promise = std::move(promise),
+         f = std::forward<F>(f)]() mutable {
+          pool.post([state = std::move(state), promise = std::move(promise),
+                     f = std::move(f)]() mutable {
+            promise.set_from([&]() -> R {
+              return detail::invoke_with_value(f, state->take());
+            });
+          });
+        });
+    return ret;
+  }
+
+  /**
+   * 结果就绪时在完成它的线程上调用 callback(state)，供 when_all/when_any 使用。
+   */
+  template <class F>
+  void on_complete(F &&callback) {
+    auto state = std::move(state_);
+    auto *raw = state.get();
+    raw->on_complete([state = std::move(state),
+                      callback = std::forward<F>(callback)]() mutable {
+      callback(*state);
+    });
+  }
+
+ private:
+  friend class Promise<T>;
+
+  explicit Future(std::shared_ptr<detail::FutureState<T>> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<detail::FutureState<T>> state_;
+};
+
+/**
+ * 在 pool 中执行 f(args...)，返回可以挂延续的 Future。
+ */
+template <class Pool, class F, class... Args>
+auto async_task(Pool &pool, F &&f, Args &&...args)
+    -> Future<decltype(f(args...))> {
+  using R = decltype(f(args...));
+  Promise<R> promise;
+  Future<R> ret = promise.get_future();
+  pool.post([promise = std::move(promise), f = std::forward<F>(f),
+             args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+    promise.set_from([&]() -> R { return std::apply(f, args); });
+  });
+  return ret;
+}
+
+template <class T>
+Future<T> make_ready_future(T value) {
+  Promise<T> promise;
+  promise.set_value(std::move(value));
+  return promise.get_future();
+}
+
+inline Future<void> make_ready_future() {
+  Promise<void> promise;
+  promise.set_value();
+  return promise.get_future();
+}
+
+/**
+ * 所有输入都就绪后就绪，结果按输入顺序排列；任一输入失败时传递第一个异常。
+ * T 为 void 时返回 Future<void>。
+ */
+template <class T>
+auto when_all(std::vector<Future<T>> futures)
+    -> Future<std::conditional_t<std::is_void<T>::value, void,
+                                 std::vector<T>>> {
+  using R = std::conditional_t<std::is_void<T>::value, void, std::vector<T>>;
+  struct State {
+    Promise<R> promise;
+    std::vector<std::optional<detail::StorageType<T>>> values;
+    std::atomic<std::size_t> remaining{0};
+    std::mutex mtx;
+    std::exception_ptr error;
+  };
+
+  auto state = std::make_shared<State>();
+  Future<R> ret = state->promise.get_future();
+  if (futures.empty()) {
+    if constexpr (std::is_void<T>::value) {
+      state->promise.set_value();
+    } else {
+      state->promise.set_value(R());
+    }
+    return ret;
+  }
+
+  state->values.resize(futures.size());
+  state->remaining = futures.size();
+  for (std::size_t i = 0; i < futures.size(); ++i) {
+    futures[i].on_complete([state, i](detail::FutureState<T> &input) {
+      try {
+        state->values[i].emplace(input.take());
+      } catch (...) {
+        std::unique_lock<std::mutex> locker(state->mtx);
+        if (!state->error) {
+          state->error = std::current_exception();
+        }
+      }
+      if (state->remaining.fetch_sub(1) != 1) {
+        return;
+      }
+      if (state->error) {
+        state->promise.set_exception(state->error);
+      } else if constexpr (std::is_void<T>::value) {
+        state->promise.set_value();
+      } else {
+        R result;
+        result.reserve(state->values.size());
+        for (auto &value : state->values) {
+          result.push_back(std::move(*value));
+        }
+        state->promise.set_value(std::move(result));
+      }
+    });
+  }
+  return ret;
+}
+
+template <class T>
+struct WhenAnyResult {
+  std::size_t index;
+  T value;
+};
+
+/**
+ * 第一个就绪的输入决定结果（包括异常），其余输入的结果被丢弃。
+ * T 为 void 时结果只有下标。
+ */
+template <class T>
+auto when_any(std::vector<Future<T>> futures)
+    -> Future<std::conditional_t<std::is_void<T>::value, std::size_t,
+                                 WhenAnyResult<T>>> {
+  using R = std::conditional_t<std::is_void<T>::value, std::size_t,
+                               WhenAnyResult<T>>;
+  if (futures.empty()) {
+    throw std::invalid_argument("when_any requires at least one future");
+  }
+
+  struct State {
+    Promise<R> promise;
+    std::atomic<bool> done{false};
+  };
+  auto state = std::make_shared<State>();
+  Future<R> ret = state->promise.get_future();
+  for (std::size_t i = 0; i < futures.size(); ++i) {
+    futures[i].on_complete([state, i](detail::FutureState<T> &input) {
+      if (state->done.exchange(true)) {
+        return;
+      }
+      state->promise.set_from([&]() -> R {
+        if constexpr (std::is_void<T>::value) {
+          input.take();
+          return i;
+        } else {
+          return R{i, input.take()};
+        }
+      });
+    });
+  }
+  return ret;
+}
+
+/**
+ * 有向无环任务图。add 添加节点，precede(a, b) 表示 a 完成后才能执行 b。
+ * run 把入度为 0 的节点投递到线程池，每个节点完成后由它所在的线程
+ * 投递已经就绪的后继节点，返回所有节点完成时就绪的 Future。
+ * 某个节点抛出异常时，尚未开始的节点不再执行，异常传递给返回的 Future。
+ * 图对象必须在返回的 Future 就绪之前保持有效，可以重复 run，但不能并发 run。
+ */
+template <class Pool>
+class TaskGraph {
+ public:
+  using NodeId = std::size_t;
+
+  explicit TaskGraph(Pool &pool) : pool_(pool) {}
+
+  TaskGraph(const TaskGraph &) = delete;
+  TaskGraph &operator=(const TaskGraph &) = delete;
+
+  template <class F>
+  NodeId add(F &&fn) {
+    nodes_.emplace_back(new Node);
+    nodes_.back()->fn = MoveOnlyTask(std::forward<F>(fn));
+    return nodes_.size() - 1;
+  }
+
+  void precede(NodeId before, NodeId after) {
+    nodes_.at(before)->successors.push_back(after);
+    ++nodes_.at(after)->num_deps;
+  }
+
+  Future<void> run() {
+    check_acyclic();
+    promise_ = Promise<void>();
+    Future<void> ret = promise_.get_future();
+    if (nodes_.empty()) {
+      promise_.set_value();
+      return ret;
+    }
+
+    remaining_ = nodes_.size();
+    failed_ = false;
+    error_ = nullptr;
+    for (auto &node : nodes_) {
+      node->pending = node->num_deps;
+    }
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+      if (nodes_[id]->num_deps == 0) {
+        schedule(id);
+      }
+    }
+    return ret;
+  }
+
+ private:
+  struct Node {
+    MoveOnlyTask fn;
+    std::vector<NodeId> successors;
+    int num_deps = 0;
+    std::atomic<int> pending{0};
+  };
+
+  void schedule(NodeId id) {
+    pool_.post([this, id]() { execute(id); });
+  }
+
+  void execute(NodeId id) {
+    Node &node = *nodes_[id];
+    if (!failed_.load()) {
+      try {
+        node.fn();
+      } catch (...) {
+        std::unique_lock<std::mutex> locker(mtx_);
+        if (!failed_.exchange(true)) {
+          error_ = std::current_exception();
+        }
+      }
+    }
+    for (NodeId next : node.successors) {
+      if (nodes_[next]->pending.fetch_sub(1) == 1) {
+        schedule(next);
+      }
+    }
+    if (remaining_.fetch_sub(1) == 1) {
+      // 等待方可能在 Future 就绪后立即销毁图，先把 promise 移出成员
+      Promise<void> promise = std::move(promise_);
+      if (error_) {
+        promise.set_exception(error_);
+      } else {
+        promise.set_value();
+      }
+    }
+  }
+
+  void check_acyclic() const {
+    std::vector<int> deps(nodes_.size());
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+      deps[id] = nodes_[id]->num_deps;
+      if (deps[id] == 0) {
+        ready.push_back(id);
+      }
+    }
+    std::size_t visited = 0;
+    while (!ready.empty()) {
+      NodeId id = ready.back();
+      ready.pop_back();
+      ++visited;
+      for (NodeId next : nodes_[id]->successors) {
+        if (--deps[next] == 0) {
+          ready.push_back(next);
+        }
+      }
+    }
+    if (visited != nodes_.size()) {
+      throw std::logic_error("TaskGraph contains a cycle");
+    }
+  }
+
+  Pool &pool_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::atomic<std::size_t> remaining_{0};
+  std::atomic<bool> failed_{false};
+  std::mutex mtx_;
+  std::exception_ptr error_;
+  Promise<void> promise_;
+};
+
+#endif /* THREAD_POOL_FUTURE_H */
@@ -0,0 +1,121 @@
+#ifndef THREAD_POOL_METRICS_H
+#define THREAD_POOL_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * LatencyHistogram 的快照。第 i 个桶统计 [2^i, 2^(i+1)) 纳秒的样本，第 0 个桶包含 0。
+ */
+struct HistogramSnapshot {
+  static constexpr int kNumBuckets = 40;
+
+  std::array<uint64_t, kNumBuckets> buckets{};
+  uint64_t count = 0;
+  uint64_t sum_ns = 0;
+
+  double mean_ns() const { return count == 0 ? 0.0 : double(sum_ns) / count; }
+
+  void merge(const HistogramSnapshot &other) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+      buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sum_ns += other.sum_ns;
+  }
+
+  /**
+   * 返回第 p（0-100）百分位所在桶的上界（纳秒），是近似值。
+   */
+  uint64_t percentile_ns(double p) const {
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(count * p / 100.0);
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+      seen += buckets[i];
+      if (seen > target) {
+        return (uint64_t(1) << (i + 1)) - 1;
+      }
+    }
+    return (uint64_t(1) << kNumBuckets) - 1;
+  }
+};
+
+/**
+ * 以 2 的幂为桶边界的无锁延迟直方图，record 只有两次 relaxed 原子加。
+ */
+class LatencyHistogram {
+ public:
+  void record(std::chrono::nanoseconds latency) {
+    int64_t ns = latency.count();
+    uint64_t value = ns < 0 ? 0 : static_cast<uint64_t>(ns);
+    buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  HistogramSnapshot snapshot() const {
+    HistogramSnapshot snap;
+    for (int i = 0; i < HistogramSnapshot::kNumBuckets; ++i) {
+      snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+      snap.count += snap.buckets[i];
+    }
+    snap.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+    return snap;
+  }
+
+ private:
+  static int bucket_of(uint64_t value) {
+#if defined(__GNUC__)
+    int bucket = value <= 1 ? 0 : 63 - __builtin_clzll(value);
+    return bucket < HistogramSnapshot::kNumBuckets
+               ? bucket
+               : HistogramSnapshot::kNumBuckets - 1;
+#else
+    int bucket = 0;
+    while (value > 1 && bucket < HistogramSnapshot::kNumBuckets - 1) {
+      value >>= 1;
+      ++bucket;
+    }
+    return bucket;
+#endif
+  }
+
+  std::array<std::atomic<uint64_t>, HistogramSnapshot::kNumBuckets> buckets_{};
+  std::atomic<uint64_t> sum_ns_{0};
+};
+
+/**
+ * 单个工作线程的统计。
+ */
+struct WorkerMetrics {
+  int id = 0;
+  int node = 0;
+  uint64_t tasks = 0;     // 已执行的任务数
+  uint64_t busy_ns = 0;   // 执行任务的总时间，不含正在执行的任务
+  uint64_t alive_ns = 0;  // 线程启动至今的时间
+
+  double busy_ratio() const {
+    return alive_ns == 0 ? 0.0 : double(busy_ns) / alive_ns;
+  }
+};
+
+/**
+ * 线程池的统计快照。enabled 为 false（编译时未开启统计）时只有 queue_depth 和 wait 有效。
+ */
+struct ThreadPoolMetrics {
+  bool enabled = false;
+  uint64_t queue_depth = 0;  // 排队中的任务数
+  uint64_t completed = 0;    // 已执行的任务数，包括已退出的线程执行的
+  uint64_t wakeups = 0;      // 提交任务时唤醒休眠线程的次数
+  uint64_t steals = 0;       // 从其他节点的队列取到的任务数
+  HistogramSnapshot wait;    // 入队到开始执行的时间
+  HistogramSnapshot run;     // 任务的执行时间
+  std::vector<WorkerMetrics> workers;
+};
+
+#endif /* THREAD_POOL_METRICS_H */
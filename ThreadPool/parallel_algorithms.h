@@ -0,0 +1,279 @@
+#ifndef THREAD_POOL_PARALLEL_ALGORITHMS_H
+#define THREAD_POOL_PARALLEL_ALGORITHMS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * 基于线程池的并行算法：parallel_for、parallel_reduce、parallel_transform、
+ * parallel_sort。Pool 只需要提供 post() 和 size()，ThreadPool 和
+ * WorkStealingThreadPool 都可以使用。
+ *
+ * 区间被切成若干块，调用线程和池中的线程通过一个原子计数器领取块，
+ * 调用线程只等待已经被领取、正在执行的块，不等待池中的辅助任务被调度，
+ * 所以在工作线程里调用也不会死锁。在某个并行算法的块内部再次调用时
+ * （嵌套并行），直接在当前线程串行执行，避免任务数量成倍膨胀。
+ */
+
+namespace detail {
+
+inline thread_local int parallel_depth = 0;
+
+struct ChunkState {
+  std::size_t num_chunks = 0;
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> done{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+/**
+ * 不断领取块并执行 body(chunk)，直到所有块都被领取。
+ */
+template <class Body>
+void run_chunks(ChunkState &state, const Body &body) {
+  ++parallel_depth;
+  while (true) {
+    std::size_t chunk = state.next.fetch_add(1);
+    if (chunk >= state.num_chunks) {
+      break;
+    }
+    if (!state.failed.load(std::memory_order_relaxed)) {
+      try {
+        body(chunk);
+      } catch (...) {
+        std::unique_lock<std::mutex> locker(state.mtx);
+        if (!state.failed.exchange(true)) {
+          state.error = std::current_exception();
+        }
+      }
+    }
+    if (state.done.fetch_add(1) + 1 == state.num_chunks) {
+      std::unique_lock<std::mutex> locker(state.mtx);
+      state.cv.notify_all();
+    }
+  }
+  --parallel_depth;
+}
+
+/**
+ * 并行执行 body(0) ... body(num_chunks - 1)，调用线程也参与执行。
+ */
+template <class Pool, class Body>
+void parallel_chunks(Pool &pool, std::size_t num_chunks, const Body &body) {
+  if (num_chunks == 0) {
+    return;
+  }
+  if (num_chunks == 1 || parallel_depth > 0 || pool.size() <= 0) {
+    for (std::size_t i = 0; i < num_chunks; ++i) {
+      body(i);
+    }
+    return;
+  }
+
+  // 辅助任务可能在算法返回之后才被调度，因此状态用 shared_ptr 持有；
+  // 这时所有块都已被领取，辅助任务不会再访问 body。
+  auto state = std::make_shared<ChunkState>();
+  state->num_chunks = num_chunks;
+  const Body *body_ptr = &body;
+  std::size_t helpers =
+      std::min<std::size_t>(static_cast<std::size_t>(pool.size()),
+                            num_chunks - 1);
+  for (std::size_t i = 0; i < helpers; ++i) {
+    pool.post([state, body_ptr]() { run_chunks(*state, *body_ptr); });
+  }
+
+  run_chunks(*state, body);
+
+  for (int spin = 0; spin < 64 && state->done.load() < num_chunks; ++spin) {
+    std::this_thread::yield();
+  }
+  {
+    std::unique_lock<std::mutex> locker(state->mtx);
+    state->cv.wait(locker,
+                   [&state, num_chunks]() { return state->done == num_chunks; });
+  }
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+/**
+ * 自动选择块大小：每个参与线程大约分到 8 块，便于负载均衡。
+ */
+template <class Pool>
+std::size_t auto_grain(Pool &pool, std::size_t n) {
+  std::size_t participants = static_cast<std::size_t>(pool.size()) + 1;
+  return std::max<std::size_t>(1, n / (participants * 8));
+}
+
+}  // namespace detail
+
+/**
+ * 对 [first, last) 中的每个下标 i 调用 fn(i)。grain 为 0 时自动选择块大小。
+ */
+template <class Pool, class Index, class F>
+void parallel_for(Pool &pool, Index first, Index last, F &&fn,
+                  std::size_t grain = 0) {
+  if (!(first < last)) {
+    return;
+  }
+  std::size_t n = static_cast<std::size_t>(last - first);
+  if (grain == 0) {
+    grain = detail::auto_grain(pool, n);
+  }
+  std::size_t num_chunks = (n + grain - 1) / grain;
+  detail::parallel_chunks(pool, num_chunks, [&](std::size_t chunk) {
+    Index begin = first + static_cast<Index>(chunk * grain);
+    Index end = first + static_cast<Index>(std::min(n, (chunk + 1) * grain));
+    for (Index i = begin; i != end; ++i) {
+      fn(i);
+    }
+  });
+}
+
+/**
+ * 并行归约，语义同 std::reduce(first, last, init, op)。
+ * 各块的部分结果按块的顺序合并，op 满足结合律时结果确定。
+ */
+template <class Pool, class RandomIt, class T, class BinaryOp = std::plus<>>
+T parallel_reduce(Pool &pool, RandomIt first, RandomIt last, T init,
+                  BinaryOp op = BinaryOp(), std::size_t grain = 0) {
+  std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  if (n == 0) {
+    return init;
+  }
+  if (grain == 0) {
+    grain = detail::auto_grain(pool, n);
+  }
+  std::size_t num_chunks = (n + grain - 1) / grain;
+  std::vector<T> partial(num_chunks);
+  detail::parallel_chunks(pool, num_chunks, [&](std::size_t chunk) {
+    RandomIt begin = first + chunk * grain;
+    RandomIt end = first + std::min(n, (chunk + 1) * grain);
+    T acc = *begin;
+    for (++begin; begin != end; ++begin) {
+      acc = op(std::move(acc), *begin);
+    }
+    partial[chunk] = std::move(acc);
+  });
+  for (auto &value : partial) {
+    init = op(std::move(init), std::move(value));
+  }
+  return init;
+}
+
+/**
+ * 并行变换，语义同 std::transform(first, last, d_first, op)。
+ */
+template <class Pool, class RandomIt, class OutputIt, class UnaryOp>
+OutputIt parallel_transform(Pool &pool, RandomIt first, RandomIt last,
+                            OutputIt d_first, UnaryOp op,
+                            std::size_t grain = 0) {
+  std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  if (n == 0) {
+    return d_first;
+  }
+  if (grain == 0) {
+    grain = detail::auto_grain(pool, n);
+  }
+  std::size_t num_chunks = (n + grain - 1) / grain;
+  detail::parallel_chunks(pool, num_chunks, [&](std::size_t chunk) {
+    std::size_t begin = chunk * grain;
+    std::size_t end = std::min(n, (chunk + 1) * grain);
+    std::transform(first + begin, first + end, d_first + begin, op);
+  });
+  return d_first + n;
+}
+
+/**
+ * 并行归并排序：先并行地对每一块做 std::sort，再逐轮两两归并。
+ * 每次归并按 merge path 切成多段并行执行，最后几轮也能用满所有线程。
+ * 需要 O(n) 的额外缓冲区，元素类型需要可默认构造；排序不稳定。
+ */
+template <class Pool, class RandomIt, class Compare = std::less<>>
+void parallel_sort(Pool &pool, RandomIt first, RandomIt last,
+                   Compare comp = Compare()) {
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+  const std::size_t kMinBlock = 1 << 14;
+
+  std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  std::size_t participants = static_cast<std::size_t>(pool.size()) + 1;
+  std::size_t num_blocks = std::min(participants * 4, n / kMinBlock);
+  if (num_blocks <= 1 || detail::parallel_depth > 0) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  std::vector<std::size_t> bounds(num_blocks + 1);
+  for (std::size_t i = 0; i <= num_blocks; ++i) {
+    bounds[i] = n * i / num_blocks;
+  }
+  detail::parallel_chunks(pool, num_blocks, [&](std::size_t block) {
+    std::sort(first + bounds[block], first + bounds[block + 1], comp);
+  });
+
+  std::vector<value_type> buffer(n);
+  bool in_buffer = false;
+  for (std::size_t width = 1; width < num_blocks; width *= 2) {
+    std::size_t pairs = (num_blocks + 2 * width - 1) / (2 * width);
+    std::size_t pieces = std::max<std::size_t>(1, participants * 2 / pairs);
+
+    auto merge_round = [&](auto src, auto dst) {
+      detail::parallel_chunks(pool, pairs * pieces, [&](std::size_t task) {
+        std::size_t pair = task / pieces;
+        std::size_t piece = task % pieces;
+        std::size_t lo = bounds[std::min(num_blocks, 2 * pair * width)];
+        std::size_t mid = bounds[std::min(num_blocks, (2 * pair + 1) * width)];
+        std::size_t hi = bounds[std::min(num_blocks, (2 * pair + 2) * width)];
+
+        // 在左半部分等距取切分点，右半部分用 lower_bound 找到对应位置
+        auto split = [&](std::size_t k) -> std::pair<std::size_t, std::size_t> {
+          if (k == pieces) {
+            return {mid, hi};
+          }
+          std::size_t a = lo + (mid - lo) * k / pieces;
+          if (a == lo) {
+            return {lo, mid};
+          }
+          std::size_t b = static_cast<std::size_t>(
+              std::lower_bound(src + mid, src + hi, src[a], comp) - src);
+          return {a, b};
+        };
+        auto begin = split(piece);
+        auto end = split(piece + 1);
+        std::size_t out = lo + (begin.first - lo) + (begin.second - mid);
+        std::merge(std::make_move_iterator(src + begin.first),
+                   std::make_move_iterator(src + end.first),
+                   std::make_move_iterator(src + begin.second),
+                   std::make_move_iterator(src + end.second), dst + out, comp);
+      });
+    };
+
+    if (in_buffer) {
+      merge_round(buffer.begin(), first);
+    } else {
+      merge_round(first, buffer.begin());
+    }
+    in_buffer = !in_buffer;
+  }
+
+  if (in_buffer) {
+    parallel_transform(pool, buffer.begin(), buffer.end(), first,
+                       [](value_type &v) { return std::move(v); });
+  }
+}
+
+#endif /* THREAD_POOL_PARALLEL_ALGORITHMS_H */
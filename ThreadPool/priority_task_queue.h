@@ -0,0 +1,193 @@
+#ifndef THREAD_POOL_PRIORITY_TASK_QUEUE_H
+#define THREAD_POOL_PRIORITY_TASK_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "cancellation.h"
+#include "metrics.h"
+#include "task.h"
+
+enum class TaskPriority { kHigh = 0, kNormal = 1, kBackground = 2 };
+
+constexpr int kNumTaskPriorities = 3;
+
+/**
+ * 某个优先级的统计快照。
+ */
+struct PriorityStats {
+  uint64_t depth = 0;      // 当前排队的任务数
+  uint64_t submitted = 0;  // 累计提交数
+  uint64_t expired = 0;    // 因超过截止时间而被丢弃的任务数
+  uint64_t cancelled = 0;  // 被取消或被 shutdown_now 丢弃的任务数
+  HistogramSnapshot wait;  // 入队到开始执行的等待时间
+};
+
+struct ScheduledTask {
+  using Clock = std::chrono::steady_clock;
+
+  MoveOnlyTask task;
+  Clock::time_point enqueue_time;
+  Clock::time_point deadline = Clock::time_point::max();
+  TaskPriority priority = TaskPriority::kNormal;
+  CancellationToken token;
+
+  bool has_deadline() const { return deadline != Clock::time_point::max(); }
+};
+
+/**
+ * 多优先级任务队列，本身不加锁，由线程池的互斥量保护。
+ *
+ * 调度规则：
+ *  - 总是优先取高优先级的任务；
+ *  - 同一优先级内，带截止时间的任务按截止时间先后执行（EDF），然后才是普通的 FIFO 任务；
+ *    FIFO 任务连续被截止时间任务跳过 kFifoStarvationLimit 次后执行一个；
+ *  - 低优先级非空时，每被跳过一次计数加一，达到 kStarvationLimit 后强制执行一个，
+ *    保证后台任务不会饿死。
+ * 统计数据使用原子变量，读取时不需要加锁。
+ */
+class PriorityTaskQueue {
+ public:
+  using Clock = ScheduledTask::Clock;
+
+  // 每个优先级最多被连续跳过的次数
+  static constexpr std::array<int, kNumTaskPriorities> kStarvationLimit = {
+      0, 8, 32};
+
+  // 同一优先级内 FIFO 任务最多被截止时间任务连续跳过的次数
+  static constexpr int kFifoStarvationLimit = 8;
+
+  bool empty() const { return size_ == 0; }
+
+  std::size_t size() const { return size_; }
+
+  void push(ScheduledTask task) {
+    Level &level = levels_[static_cast<int>(task.priority)];
+    if (task.has_deadline()) {
+      level.deadline_heap.push_back(std::move(task));
+      std::push_heap(level.deadline_heap.begin(), level.deadline_heap.end(),
+                     later_deadline);
+    } else {
+      level.fifo.push_back(std::move(task));
+    }
+    level.depth.fetch_add(1, std::memory_order_relaxed);
+    level.submitted.fetch_add(1, std::memory_order_relaxed);
+    ++size_;
+  }
+
+  /**
+   * 取出下一个要执行的任务，队列不能为空。同时记录该任务的等待时间。
+   */
+  ScheduledTask pop(Clock::time_point now) {
+    int chosen = -1;
+    for (int i = 0; i < kNumTaskPriorities; ++i) {
+      if (!levels_[i].empty()) {
+        chosen = i;
+        break;
+      }
+    }
+    for (int i = kNumTaskPriorities - 1; i > chosen; --i) {
+      if (!levels_[i].empty() && levels_[i].skipped >= kStarvationLimit[i]) {
+        chosen = i;
+        break;
+      }
+    }
+    for (int i = chosen + 1; i < kNumTaskPriorities; ++i) {
+      if (!levels_[i].empty()) {
+        ++levels_[i].skipped;
+      }
+    }
+
+    Level &level = levels_[chosen];
+    level.skipped = 0;
+    ScheduledTask task;
+    if (!level.deadline_heap.empty() &&
+        (level.fifo.empty() || level.fifo_skipped < kFifoStarvationLimit)) {
+      std::pop_heap(level.deadline_heap.begin(), level.deadline_heap.end(),
+                    later_deadline);
+      task = std::move(level.deadline_heap.back());
+      level.deadline_heap.pop_back();
+      if (!level.fifo.empty()) {
+        ++level.fifo_skipped;
+      }
+    } else {
+      task = level.fifo.pop_front();
+      level.fifo_skipped = 0;
+    }
+    level.depth.fetch_sub(1, std::memory_order_relaxed);
+    level.wait.record(now - task.enqueue_time);
+    --size_;
+    return task;
+  }
+
+  void record_expired(TaskPriority priority) {
+    levels_[static_cast<int>(priority)].expired.fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  void record_cancelled(TaskPriority priority) {
+    levels_[static_cast<int>(priority)].cancelled.fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  /**
+   * 取出全部任务，不记录等待时间，计入 cancelled。
+   */
+  std::vector<ScheduledTask> take_all() {
+    std::vector<ScheduledTask> tasks;
+    tasks.reserve(size_);
+    for (auto &level : levels_) {
+      while (!level.fifo.empty()) {
+        tasks.push_back(level.fifo.pop_front());
+      }
+      for (auto &task : level.deadline_heap) {
+        tasks.push_back(std::move(task));
+      }
+      level.deadline_heap.clear();
+      level.cancelled.fetch_add(level.depth.exchange(0),
+                                std::memory_order_relaxed);
+    }
+    size_ = 0;
+    return tasks;
+  }
+
+  PriorityStats stats(TaskPriority priority) const {
+    const Level &level = levels_[static_cast<int>(priority)];
+    PriorityStats stats;
+    stats.depth = level.depth.load(std::memory_order_relaxed);
+    stats.submitted = level.submitted.load(std::memory_order_relaxed);
+    stats.expired = level.expired.load(std::memory_order_relaxed);
+    stats.cancelled = level.cancelled.load(std::memory_order_relaxed);
+    stats.wait = level.wait.snapshot();
+    return stats;
+  }
+
+ private:
+  struct Level {
+    RingQueue<ScheduledTask> fifo;
+    std::vector<ScheduledTask> deadline_heap;
+    int skipped = 0;
+    int fifo_skipped = 0;
+
+    std::atomic<uint64_t> depth{0};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> expired{0};
+    std::atomic<uint64_t> cancelled{0};
+    LatencyHistogram wait;
+
+    bool empty() const { return fifo.empty() && deadline_heap.empty(); }
+  };
+
+  static bool later_deadline(const ScheduledTask &a, const ScheduledTask &b) {
+    return a.deadline > b.deadline;
+  }
+
+  std::array<Level, kNumTaskPriorities> levels_;
+  std::size_t size_ = 0;
+};
+
+#endif /* THREAD_POOL_PRIORITY_TASK_QUEUE_H */
@@ -0,0 +1,478 @@
+#ifndef THREAD_POOL_TASK_H
+#define THREAD_POOL_TASK_H
+
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail {
+
+/**
+ * 按大小分级（32/64/128/256 字节）的内存块池。
+ *
+ * 每个线程有一个本地缓存，命中时不加锁；本地缓存为空时从全局链表批量取块，
+ * 本地缓存过多时批量归还。全局链表为空时才一次性向系统申请一批块，
+ * 因此稳定运行后分配和释放都不会访问全局分配器。超过 256 字节的请求直接走 operator new。
+ */
+class BlockPool {
+ public:
+  static constexpr std::size_t kMaxBlockSize = 256;
+
+  static void *allocate(std::size_t n) {
+    if (n > kMaxBlockSize) {
+      return ::operator new(n);
+    }
+    int cls = size_class(n);
+    LocalCache *cache = local_cache();
+    if (cache == nullptr) {
+      return allocate_central(cls);
+    }
+    if (cache->head[cls] == nullptr) {
+      refill(*cache, cls);
+    }
+    FreeNode *node = cache->head[cls];
+    cache->head[cls] = node->next;
+    --cache->count[cls];
+    return node;
+  }
+
+  static void deallocate(void *p, std::size_t n) {
+    if (n > kMaxBlockSize) {
+      ::operator delete(p);
+      return;
+    }
+    int cls = size_class(n);
+    FreeNode *node = static_cast<FreeNode *>(p);
+    LocalCache *cache = local_cache();
+    if (cache == nullptr) {
+      deallocate_central(node, cls);
+      return;
+    }
+    node->next = cache->head[cls];
+    cache->head[cls] = node;
+    if (++cache->count[cls] > 2 * kBatch) {
+      flush(*cache, cls, kBatch);
+    }
+  }
+
+ private:
+  static constexpr int kNumClasses = 4;
+  static constexpr int kBatch = 32;
+
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  struct Central {
+    std::mutex mtx;
+    FreeNode *head[kNumClasses] = {};
+  };
+
+  struct LocalCache {
+    FreeNode *head[kNumClasses] = {};
+    int count[kNumClasses] = {};
+
+    ~LocalCache() {
+      for (int cls = 0; cls < kNumClasses; ++cls) {
+        flush(*this, cls, count[cls]);
+      }
+      cache_destroyed_ = true;
+    }
+  };
+
+  // 本线程的 LocalCache 已经析构。bool 没有析构函数，线程退出的整个过程中都可以读
+  inline static thread_local bool cache_destroyed_ = false;
+
+  static int size_class(std::size_t n) {
+    return n <= 32 ? 0 : n <= 64 ? 1 : n <= 128 ? 2 : 3;
+  }
+
+  static std::size_t block_size(int cls) { return std::size_t(32) << cls; }
+
+  static Central &central() {
+    // 故意不析构：线程退出时 LocalCache 仍需要把块归还到这里
+    static Central *central = new Central;
+    return *central;
+  }
+
+  /**
+   * 线程退出或静态对象析构时 LocalCache 可能已经析构，此时返回 nullptr，
+   * 由调用者直接使用全局链表。
+   */
+  static LocalCache *local_cache() {
+    if (cache_destroyed_) {
+      return nullptr;
+    }
+    static thread_local LocalCache cache;
+    return &cache;
+  }
+
+  static void *allocate_central(int cls) {
+    Central &c = central();
+    {
+      std::unique_lock<std::mutex> locker(c.mtx);
+      if (FreeNode *node = c.head[cls]) {
+        c.head[cls] = node->next;
+        return node;
+      }
+    }
+    return ::operator new(block_size(cls));
+  }
+
+  static void deallocate_central(FreeNode *node, int cls) {
+    Central &c = central();
+    std::unique_lock<std::mutex> locker(c.mtx);
+    node->next = c.head[cls];
+    c.head[cls] = node;
+  }
+
+  static void refill(LocalCache &cache, int cls) {
+    Central &c = central();
+    {
+      std::unique_lock<std::mutex> locker(c.mtx);
+      while (c.head[cls] != nullptr && cache.count[cls] < kBatch) {
+        FreeNode *node = c.head[cls];
+        c.head[cls] = node->next;
+        node->next = cache.head[cls];
+        cache.head[cls] = node;
+        ++cache.count[cls];
+      }
+    }
+    if (cache.head[cls] != nullptr) {
+      return;
+    }
+
+    std::size_t size = block_size(cls);
+    char *chunk = static_cast<char *>(::operator new(size * kBatch));
+    for (int i = 0; i < kBatch; ++i) {
+      FreeNode *node = reinterpret_cast<FreeNode *>(chunk + i * size);
+      node->next = cache.head[cls];
+      cache.head[cls] = node;
+    }
+    cache.count[cls] += kBatch;
+  }
+
+  static void flush(LocalCache &cache, int cls, int n) {
+    if (n <= 0) {
+      return;
+    }
+    Central &c = central();
+    std::unique_lock<std::mutex> locker(c.mtx);
+    for (int i = 0; i < n && cache.head[cls] != nullptr; ++i) {
+      FreeNode *node = cache.head[cls];
+      cache.head[cls] = node->next;
+      node->next = c.head[cls];
+      c.head[cls] = node;
+      --cache.count[cls];
+    }
+  }
+};
+
+/**
+ * BlockPool 的块只保证默认对齐，对齐要求超过 max_align_t 的对象改用带对齐参数的 operator new。
+ */
+template <class T>
+void *allocate_object(std::size_t bytes) {
+  if constexpr (alignof(T) > alignof(std::max_align_t)) {
+    return ::operator new(bytes, std::align_val_t(alignof(T)));
+  } else {
+    return BlockPool::allocate(bytes);
+  }
+}
+
+template <class T>
+void deallocate_object(void *p, std::size_t bytes) noexcept {
+  if constexpr (alignof(T) > alignof(std::max_align_t)) {
+    ::operator delete(p, bytes, std::align_val_t(alignof(T)));
+  } else {
+    BlockPool::deallocate(p, bytes);
+  }
+}
+
+}  // namespace detail
+
+/**
+ * 使用 BlockPool 的分配器，用于 std::promise 的共享状态。
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(detail::allocate_object<T>(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    detail::deallocate_object<T>(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+/**
+ * 只能移动的 void() 可调用对象，相当于带小对象优化的 std::function。
+ *
+ * 不超过 kInlineSize 字节且移动构造不抛异常的可调用对象直接存放在内部缓冲区，
+ * 更大的对象从 BlockPool 分配，超过默认对齐的对象用带对齐参数的 operator new。
+ */
+class MoveOnlyTask {
+ public:
+  static constexpr std::size_t kInlineSize = 64;
+
+  MoveOnlyTask() noexcept = default;
+
+  template <class F, class = std::enable_if_t<
+                         !std::is_same<std::decay_t<F>, MoveOnlyTask>::value>>
+  MoveOnlyTask(F &&f) {
+    using Fn = std::decay_t<F>;
+    if constexpr (fits_inline<Fn>()) {
+      new (storage_) Fn(std::forward<F>(f));
+      vtable_ = &inline_vtable<Fn>;
+    } else {
+      void *mem = detail::allocate_object<Fn>(sizeof(Fn));
+      try {
+        new (mem) Fn(std::forward<F>(f));
+      } catch (...) {
+        detail::deallocate_object<Fn>(mem, sizeof(Fn));
+        throw;
+      }
+      *reinterpret_cast<void **>(storage_) = mem;
+      vtable_ = &heap_vtable<Fn>;
+    }
+  }
+
+  MoveOnlyTask(MoveOnlyTask &&other) noexcept { move_from(other); }
+
+  MoveOnlyTask &operator=(MoveOnlyTask &&other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+
+  MoveOnlyTask(const MoveOnlyTask &) = delete;
+  MoveOnlyTask &operator=(const MoveOnlyTask &) = delete;
+
+  ~MoveOnlyTask() { reset(); }
+
+  void operator()() { vtable_->invoke(storage_); }
+
+  explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+  void reset() noexcept {
+    if (vtable_ != nullptr) {
+      vtable_->destroy(storage_);
+      vtable_ = nullptr;
+    }
+  }
+
+ private:
+  struct VTable {
+    void (*invoke)(void *);
+    void (*move)(void *dst, void *src) noexcept;
+    void (*destroy)(void *) noexcept;
+  };
+
+  template <class Fn>
+  static constexpr bool fits_inline() {
+    return sizeof(Fn) <= kInlineSize &&
+           alignof(Fn) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<Fn>::value;
+  }
+
+  template <class Fn>
+  static constexpr VTable inline_vtable = {
+      [](void *p) { (*static_cast<Fn *>(p))(); },
+      [](void *dst, void *src) noexcept {
+        new (dst) Fn(std::move(*static_cast<Fn *>(src)));
+        static_cast<Fn *>(src)->~Fn();
+      },
+      [](void *p) noexcept { static_cast<Fn *>(p)->~Fn(); }};
+
+  template <class Fn>
+  static constexpr VTable heap_vtable = {
+      [](void *p) { (**static_cast<Fn **>(p))(); },
+      [](void *dst, void *src) noexcept {
+        *static_cast<Fn **>(dst) = *static_cast<Fn **>(src);
+      },
+      [](void *p) noexcept {
+        Fn *fn = *static_cast<Fn **>(p);
+        fn->~Fn();
+        detail::deallocate_object<Fn>(fn, sizeof(Fn));
+      }};
+
+  void move_from(MoveOnlyTask &other) noexcept {
+    if (other.vtable_ != nullptr) {
+      other.vtable_->move(storage_, other.storage_);
+      vtable_ = other.vtable_;
+      other.vtable_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const VTable *vtable_ = nullptr;
+};
+
+/**
+ * 容量按 2 的幂增长、从不收缩的环形队列，稳定后 push/pop 不再分配内存。
+ * 支持从尾部弹出，供工作窃取线程池的本地队列使用。
+ */
+template <class T>
+class RingQueue {
+ public:
+  explicit RingQueue(std::size_t capacity = 64) {
+    std::size_t cap = 1;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    buffer_.resize(cap);
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  std::size_t size() const { return size_; }
+
+  T &front() { return buffer_[head_]; }
+
+  void push_back(T value) {
+    if (size_ == buffer_.size()) {
+      grow();
+    }
+    buffer_[(head_ + size_) & (buffer_.size() - 1)] = std::move(value);
+    ++size_;
+  }
+
+  T pop_front() {
+    T value = std::move(buffer_[head_]);
+    head_ = (head_ + 1) & (buffer_.size() - 1);
+    --size_;
+    return value;
+  }
+
+  T pop_back() {
+    --size_;
+    return std::move(buffer_[(head_ + size_) & (buffer_.size() - 1)]);
+  }
+
+ private:
+  void grow() {
+    std::vector<T> buffer(buffer_.size() * 2);
+    for (std::size_t i = 0; i < size_; ++i) {
+      buffer[i] = std::move(buffer_[(head_ + i) & (buffer_.size() - 1)]);
+    }
+    buffer_.swap(buffer);
+    head_ = 0;
+  }
+
+  std::vector<T> buffer_;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+};
+
+using TaskQueue = RingQueue<MoveOnlyTask>;
+
+namespace detail {
+
+/**
+ * 保存可调用对象、参数和 promise，执行后把结果或异常写入 promise。
+ */
+template <class R, class F, class... Args>
+class PromiseInvoker {
+ public:
+  template <class Fn, class... As>
+  PromiseInvoker(std::promise<R> promise, Fn &&f, As &&...args)
+      : promise_(std::move(promise)),
+        f_(std::forward<Fn>(f)),
+        args_(std::forward<As>(args)...) {}
+
+  void operator()() {
+    try {
+      if constexpr (std::is_void<R>::value) {
+        std::apply(f_, args_);
+        promise_.set_value();
+      } else {
+        promise_.set_value(std::apply(f_, args_));
+      }
+    } catch (...) {
+      promise_.set_exception(std::current_exception());
+    }
+  }
+
+ private:
+  std::promise<R> promise_;
+  F f_;
+  std::tuple<Args...> args_;
+};
+
+/**
+ * 保存可调用对象和参数，执行时忽略返回值，用于不需要结果的任务。
+ */
+template <class F, class... Args>
+class BoundInvoker {
+ public:
+  template <class Fn, class... As>
+  BoundInvoker(Fn &&f, As &&...args)
+      : f_(std::forward<Fn>(f)), args_(std::forward<As>(args)...) {}
+
+  void operator()() { std::apply(f_, args_); }
+
+ private:
+  F f_;
+  std::tuple<Args...> args_;
+};
+
+}  // namespace detail
+
+/**
+ * 把 f(args...) 打包成一个不关心返回值的任务，没有 promise/future 的开销。
+ */
+template <class F, class... Args>
+MoveOnlyTask make_task(F &&f, Args &&...args) {
+  if constexpr (sizeof...(Args) == 0) {
+    return MoveOnlyTask(std::forward<F>(f));
+  } else {
+    return MoveOnlyTask(
+        detail::BoundInvoker<std::decay_t<F>, std::decay_t<Args>...>(
+            std::forward<F>(f), std::forward<Args>(args)...));
+  }
+}
+
+/**
+ * 把 f(args...) 打包成一个任务，结果通过 promise 返回。
+ * promise 的共享状态从 BlockPool 分配，小的可调用对象存放在 MoveOnlyTask 内部，
+ * 所以常见的提交路径不会调用全局分配器。
+ */
+template <class R, class F, class... Args>
+MoveOnlyTask make_promise_task(std::promise<R> promise, F &&f,
+                               Args &&...args) {
+  return MoveOnlyTask(
+      detail::PromiseInvoker<R, std::decay_t<F>, std::decay_t<Args>...>(
+          std::move(promise), std::forward<F>(f),
+          std::forward<Args>(args)...));
+}
+
+template <class R>
+std::promise<R> make_pooled_promise() {
+  return std::promise<R>(std::allocator_arg, PoolAllocator<char>());
+}
+
+#endif /* THREAD_POOL_TASK_H */
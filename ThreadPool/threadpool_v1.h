@@ -1,39 +1,132 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#include "affinity.h"
+#include "cancellation.h"
+#include "metrics.h"
+#include "priority_task_queue.h"
+#include "task.h"
+
+// 定义为 1 时统计任务执行时间、线程利用率、唤醒和窃取次数，
+// 每个任务多一次读时钟和几次 relaxed 原子加。默认关闭，不影响热路径
+#ifndef THREADPOOL_METRICS
+#define THREADPOOL_METRICS 0
+#endif
+
+/**
+ * 有界队列已满时提交任务的处理方式。
+ */
+enum class QueueFullPolicy {
+  kBlock,       // 阻塞提交者直到队列有空位（工作线程中提交时退化为 kCallerRuns）
+  kReject,      // 抛出 QueueFullError
+  kCallerRuns,  // 在提交者的线程中直接执行
+};
+
+class QueueFullError : public std::runtime_error {
+ public:
+  QueueFullError() : std::runtime_error("ThreadPool queue is full.") {}
+};
+
+/**
+ * 线程池的线程数策略。min_threads == max_threads 时线程数固定。
+ */
+struct ThreadPoolOptions {
+  int min_threads = 1;
+  int max_threads = static_cast<int>(std::thread::hardware_concurrency());
+  // 空闲超过 idle_timeout 且线程数大于 min_threads 时，工作线程退出
+  std::chrono::milliseconds idle_timeout{5000};
+  // 没有空闲线程且积压任务数不少于线程数时，每隔 spawn_interval 最多新增一个线程
+  std::chrono::microseconds spawn_interval{1000};
+  // 休眠前自旋等待新任务的最大次数，实际次数会根据自旋是否等到任务自适应调整。
+  // 单核机器上自旋没有意义，默认为 0
+  int max_spin = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+
+  // 工作线程可以使用的 CPU，为空时不限制
+  std::vector<int> cpus;
+  // 每个工作线程绑定到单个 CPU，否则绑定到整个 CPU 集合（或所在的 NUMA 节点）
+  bool pin_per_core = false;
+  // 按 NUMA 节点分组工作线程，每个节点一个本地任务队列
+  bool numa_aware = false;
+
+  // 排队任务数的上限，0 表示不限制
+  size_t max_queue_size = 0;
+  QueueFullPolicy full_policy = QueueFullPolicy::kBlock;
+};
+
 class ThreadPool {
  public:
-  using Task = std::packaged_task<void()>;
+  using Task = MoveOnlyTask;
+  using Clock = std::chrono::steady_clock;
 
   ThreadPool(int numThreads = std::thread::hardware_concurrency())
-      : numThreads_(numThreads), stop_(false) {
+      : numThreads_(0), stop_(false) {
     int num = std::thread::hardware_concurrency();
-    numThreads_ = numThreads > num ? num : numThreads;
-    start();
+    ThreadPoolOptions options;
+    options.min_threads = options.max_threads =
+        numThreads > num ? num : numThreads;
+    start(options);
   }
 
-  ~ThreadPool() {
-    stop_ = true;
-    cv_.notify_all();
-    for (auto &t : pool_) {
-      if (t.joinable()) {
-        t.join();
-      }
-    }
+  explicit ThreadPool(const ThreadPoolOptions &options)
+      : numThreads_(0), stop_(false) {
+    start(options);
   }
 
+  ~ThreadPool() { shutdown(false); }
+
+  /**
+   * 停止接受新任务，等待已提交的任务全部执行完，然后回收所有线程。
+   * 之后提交任务会抛出异常。不要在线程池的工作线程中调用。
+   */
+  void drain() { shutdown(false); }
+
+  /**
+   * 停止接受新任务，丢弃还没开始的任务（对应的 future 抛出 broken_promise），
+   * 等待正在执行的任务结束并回收所有线程。返回被丢弃的任务数。
+   */
+  size_t shutdown_now() { return shutdown(true); }
+
   template <class F, class... Args>
   auto commit_task(F &&f, Args &&...args) -> std::future<decltype(f(args...))> {
+    return commit_task_until(TaskPriority::kNormal, Clock::time_point::max(),
+                             std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  template <class F, class... Args>
+  auto commit_task(TaskPriority priority, F &&f, Args &&...args)
+      -> std::future<decltype(f(args...))> {
+    return commit_task_until(priority, Clock::time_point::max(),
+                             std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  /**
+   * 提交带截止时间的任务。到 deadline 还没有开始执行的任务会被丢弃，
+   * 对应的 future 抛出 std::future_error（broken_promise）。
+   */
+  template <class F, class... Args>
+  auto commit_task_until(TaskPriority priority, Clock::time_point deadline,
+                         F &&f, Args &&...args)
+      -> std::future<decltype(f(args...))> {
     if (stop_) {
       throw std::runtime_error("commit task on stopped ThreadPool.");
     }
@@ -41,50 +134,699 @@ class ThreadPool {
     using return_type = decltype(f(args...));
     // using return_type =
     // decltype(std::forward<F>(f)(std::forward<Args>(args)...));
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    auto ret = task->get_future();
+    auto promise = make_pooled_promise<return_type>();
+    auto ret = promise.get_future();
+    enqueue(make_promise_task(std::move(promise), std::forward<F>(f),
+                              std::forward<Args>(args)...),
+            priority, deadline);
+    return ret;
+  }
 
-    {
-      std::unique_lock<std::mutex> locker(mtx_);
-      tasks_.emplace([task]() { (*task)(); });
+  /**
+   * 提交可以取消的任务。token 在任务开始执行前被取消时任务被丢弃，
+   * future 抛出 std::future_error（broken_promise）；已经开始执行的任务需要自己检查 token。
+   */
+  template <class F, class... Args>
+  auto commit_cancellable(const CancellationToken &token, F &&f,
+                          Args &&...args) -> std::future<decltype(f(args...))> {
+    if (stop_) {
+      throw std::runtime_error("commit task on stopped ThreadPool.");
+    }
+
+    using return_type = decltype(f(args...));
+    auto promise = make_pooled_promise<return_type>();
+    auto ret = promise.get_future();
+    enqueue(make_promise_task(std::move(promise), std::forward<F>(f),
+                              std::forward<Args>(args)...),
+            TaskPriority::kNormal, Clock::time_point::max(), -1, token);
+    return ret;
+  }
+
+  /**
+   * 提交到 node（对 num_nodes() 取模）的本地队列，优先由该节点上的工作线程执行，
+   * 该节点忙不过来时其他节点的线程也会取走它。
+   */
+  template <class F, class... Args>
+  auto commit_task_on(int node, F &&f, Args &&...args)
+      -> std::future<decltype(f(args...))> {
+    if (stop_) {
+      throw std::runtime_error("commit task on stopped ThreadPool.");
     }
-    cv_.notify_one();
 
+    using return_type = decltype(f(args...));
+    auto promise = make_pooled_promise<return_type>();
+    auto ret = promise.get_future();
+    enqueue(make_promise_task(std::move(promise), std::forward<F>(f),
+                              std::forward<Args>(args)...),
+            TaskPriority::kNormal, Clock::time_point::max(), node);
     return ret;
   }
 
+  /**
+   * 提交不需要返回值的任务，不创建 future。
+   * 任务抛出的异常不会被捕获，会导致 std::terminate。
+   */
+  template <class F, class... Args,
+            class = std::enable_if_t<
+                !std::is_same<std::decay_t<F>, TaskPriority>::value>>
+  void post(F &&f, Args &&...args) {
+    post(TaskPriority::kNormal, std::forward<F>(f),
+         std::forward<Args>(args)...);
+  }
+
+  template <class F, class... Args>
+  void post(TaskPriority priority, F &&f, Args &&...args) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue(make_task(std::forward<F>(f), std::forward<Args>(args)...),
+            priority);
+  }
+
+  /**
+   * post 的指定节点版本，见 commit_task_on。
+   */
+  template <class F, class... Args>
+  void post_on(int node, F &&f, Args &&...args) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue(make_task(std::forward<F>(f), std::forward<Args>(args)...),
+            TaskPriority::kNormal, Clock::time_point::max(), node);
+  }
+
+  /**
+   * post 的可取消版本，见 commit_cancellable。
+   */
+  template <class F, class... Args>
+  void post_cancellable(const CancellationToken &token, F &&f,
+                        Args &&...args) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue(make_task(std::forward<F>(f), std::forward<Args>(args)...),
+            TaskPriority::kNormal, Clock::time_point::max(), -1, token);
+  }
+
+  /**
+   * 对 [first, last) 中的每个元素提交 fn(*it)。任务直接构造到队列中，
+   * 每 kBulkBatch 个任务加一次锁，批与批之间唤醒工作线程，执行和提交可以重叠。
+   * 有界队列放不下时按 full_policy 处理，kReject 时已经入队的部分不会撤回。
+   */
+  template <class InputIt, class F>
+  auto commit_bulk(InputIt first, InputIt last, F fn)
+      -> std::vector<std::future<decltype(fn(*first))>> {
+    if (stop_) {
+      throw std::runtime_error("commit task on stopped ThreadPool.");
+    }
+
+    using return_type = decltype(fn(*first));
+    std::vector<std::future<return_type>> ret;
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+      ret.reserve(std::distance(first, last));
+    }
+    enqueue_bulk(first, last, [&ret, &fn](auto &&value) {
+      auto promise = make_pooled_promise<return_type>();
+      ret.emplace_back(promise.get_future());
+      return make_promise_task(std::move(promise), fn,
+                               std::forward<decltype(value)>(value));
+    });
+    return ret;
+  }
+
+  /**
+   * commit_bulk 的无返回值版本。
+   */
+  template <class InputIt, class F>
+  void post_bulk(InputIt first, InputIt last, F fn) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue_bulk(first, last, [&fn](auto &&value) {
+      return make_task(fn, std::forward<decltype(value)>(value));
+    });
+  }
+
+  int size() const { return numThreads_; }
+
+  /**
+   * 任务队列（NUMA 节点）的个数，numa_aware 为 false 时为 1。
+   */
+  int num_nodes() const { return static_cast<int>(tasks_.size()); }
+
+  /**
+   * 调整线程数。增加时立即创建线程，减少时多余的线程在完成当前任务后退出。
+   * min_threads 被设为 numThreads，max_threads 不小于 numThreads。
+   */
+  void resize(int numThreads) {
+    numThreads = std::max(1, numThreads);
+    std::unique_lock<std::mutex> locker(mtx_);
+    if (stop_) {
+      throw std::runtime_error("resize stopped ThreadPool.");
+    }
+    min_threads_ = numThreads;
+    max_threads_ = std::max(max_threads_, numThreads);
+
+    int current = numThreads_ - retire_requests_;
+    if (numThreads > current) {
+      int grow = numThreads - current;
+      int cancel = std::min(grow, retire_requests_);
+      retire_requests_ -= cancel;
+      for (int i = cancel; i < grow; ++i) {
+        spawn_locked();
+      }
+    } else if (numThreads < current) {
+      retire_requests_ += current - numThreads;
+      cv_.notify_all();
+    }
+  }
+
+  /**
+   * 某个优先级的队列深度、等待时间直方图等统计，不需要停止线程池。
+   */
+  PriorityStats priority_stats(TaskPriority priority) const {
+    PriorityStats total;
+    for (auto &queue : tasks_) {
+      PriorityStats stats = queue.stats(priority);
+      total.depth += stats.depth;
+      total.submitted += stats.submitted;
+      total.expired += stats.expired;
+      total.cancelled += stats.cancelled;
+      total.wait.merge(stats.wait);
+    }
+    return total;
+  }
+
+  /**
+   * 读取统计快照，只短暂持有线程池的锁。
+   */
+  ThreadPoolMetrics metrics() const {
+    ThreadPoolMetrics metrics;
+    metrics.enabled = THREADPOOL_METRICS != 0;
+    metrics.queue_depth = queued_.load();
+    for (int i = 0; i < kNumTaskPriorities; ++i) {
+      metrics.wait.merge(priority_stats(static_cast<TaskPriority>(i)).wait);
+    }
+    metrics.run = run_time_.snapshot();
+    metrics.wakeups = wakeups_.load(std::memory_order_relaxed);
+    metrics.steals = steals_.load(std::memory_order_relaxed);
+
+    auto now = Clock::now();
+    std::unique_lock<std::mutex> locker(mtx_);
+    metrics.completed = retired_tasks_;
+    for (auto &entry : workers_) {
+      const WorkerCounters &counters = *entry.second.counters;
+      WorkerMetrics worker;
+      worker.id = entry.first;
+      worker.node = entry.second.node;
+      worker.tasks = counters.tasks.load(std::memory_order_relaxed);
+      worker.busy_ns = counters.busy_ns.load(std::memory_order_relaxed);
+      worker.alive_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            now - counters.started)
+                            .count();
+      metrics.completed += worker.tasks;
+      metrics.workers.push_back(worker);
+    }
+    locker.unlock();
+    std::sort(metrics.workers.begin(), metrics.workers.end(),
+              [](const WorkerMetrics &a, const WorkerMetrics &b) {
+                return a.id < b.id;
+              });
+    return metrics;
+  }
+
  private:
-  void start() {
-    for (int i = 0; i < numThreads_; ++i) {
-      pool_.emplace_back([this]() {
-        Task task;
-        while (true) {
-          {
-            std::unique_lock<std::mutex> locker(this->mtx_);
-            this->cv_.wait(locker, [this]() {
-              // stop_为true或任务队列不为空，则不应该被阻塞
-              return this->stop_ || !this->tasks_.empty();
-            });
-            if (this->stop_ && tasks_.empty()) {
-              return;
-            }
-
-            task = std::move(this->tasks_.front());
-            this->tasks_.pop();
-          }
+  struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> busy_ns{0};
+    Clock::time_point started = Clock::now();
+  };
+
+  size_t shutdown(bool discard) {
+    std::vector<std::thread> threads;
+    std::vector<ScheduledTask> discarded;
+    {
+      std::unique_lock<std::mutex> locker(mtx_);
+      stop_ = true;
+      if (discard) {
+        for (auto &queue : tasks_) {
+          auto tasks = queue.take_all();
+          std::move(tasks.begin(), tasks.end(), std::back_inserter(discarded));
+        }
+        queued_ = 0;
+      }
+      for (auto &worker : workers_) {
+        threads.push_back(std::move(worker.second.thread));
+      }
+      threads.push_back(std::move(last_retired_));
+    }
+    cv_.notify_all();
+    not_full_cv_.notify_all();
+    for (auto &t : threads) {
+      if (t.joinable()) {
+        t.join();
+      }
+    }
+    // 在锁外析构被丢弃的任务，promise 析构时会唤醒等待 future 的线程
+    return discarded.size();
+  }
+
+  /**
+   * 确保队列有空位。返回 false 表示应由调用者自己执行任务。
+   */
+  bool wait_for_room_locked(std::unique_lock<std::mutex> &locker) {
+    if (stop_) {
+      throw std::runtime_error("enqueue on stopped ThreadPool.");
+    }
+    if (max_queue_size_ == 0 || queued_ < max_queue_size_) {
+      return true;
+    }
+    QueueFullPolicy policy = full_policy_;
+    if (policy == QueueFullPolicy::kBlock && current_pool_ == this) {
+      // 工作线程阻塞等待自己所在的线程池可能导致死锁
+      policy = QueueFullPolicy::kCallerRuns;
+    }
+    switch (policy) {
+      case QueueFullPolicy::kReject:
+        throw QueueFullError();
+      case QueueFullPolicy::kCallerRuns:
+        return false;
+      case QueueFullPolicy::kBlock:
+        break;
+    }
+    ++blocked_producers_;
+    not_full_cv_.wait(locker, [this]() {
+      return stop_ || queued_ < max_queue_size_;
+    });
+    --blocked_producers_;
+    if (stop_) {
+      throw std::runtime_error("enqueue on stopped ThreadPool.");
+    }
+    return true;
+  }
+
+  void enqueue(Task task, TaskPriority priority,
+               Clock::time_point deadline = Clock::time_point::max(),
+               int node = -1, CancellationToken token = CancellationToken()) {
+    auto now = Clock::now();
+    ScheduledTask scheduled;
+    scheduled.task = std::move(task);
+    scheduled.enqueue_time = now;
+    scheduled.deadline = deadline;
+    scheduled.priority = priority;
+    scheduled.token = std::move(token);
+    int wake;
+    {
+      std::unique_lock<std::mutex> locker(mtx_);
+      if (!wait_for_room_locked(locker)) {
+        locker.unlock();
+        if (!scheduled.token.cancelled()) {
+          scheduled.task();
+        }
+        return;
+      }
+      tasks_[submit_node_locked(node)].push(std::move(scheduled));
+      ++queued_;
+      maybe_spawn_locked(now);
+      wake = wakeups_locked();
+    }
+    if (wake > 0) {
+#if THREADPOOL_METRICS
+      wakeups_.fetch_add(1, std::memory_order_relaxed);
+#endif
+      cv_.notify_one();
+    }
+  }
 
+  /**
+   * 把 make(*it) 返回的任务逐批构造到同一个节点的队列中，每批只加一次锁。
+   * make 抛出异常时已经入队的任务保留，唤醒工作线程后重新抛出。
+   */
+  template <class InputIt, class MakeTask>
+  void enqueue_bulk(InputIt first, InputIt last, MakeTask make) {
+    while (first != last) {
+      int wake;
+      bool wake_all;
+      {
+        std::unique_lock<std::mutex> locker(mtx_);
+        if (!wait_for_room_locked(locker)) {
+          Task task = make(*first);
+          ++first;
+          locker.unlock();
           task();
+          continue;
+        }
+        size_t count = kBulkBatch;
+        if (max_queue_size_ > 0) {
+          count = std::min(count, max_queue_size_ - queued_);
+        }
+        auto now = Clock::now();
+        PriorityTaskQueue &queue = tasks_[submit_node_locked(-1)];
+        size_t pushed = 0;
+        try {
+          for (; pushed < count && first != last; ++pushed, ++first) {
+            ScheduledTask scheduled;
+            scheduled.task = make(*first);
+            scheduled.enqueue_time = now;
+            queue.push(std::move(scheduled));
+          }
+        } catch (...) {
+          queued_ += pushed;
+          locker.unlock();
+          cv_.notify_all();
+          throw;
+        }
+        queued_ += pushed;
+        maybe_spawn_locked(now);
+        wake = wakeups_locked();
+        wake_all = wake > 0 && wake >= sleepers_;
+      }
+#if THREADPOOL_METRICS
+      wakeups_.fetch_add(wake, std::memory_order_relaxed);
+#endif
+      if (wake_all) {
+        cv_.notify_all();
+      } else {
+        for (int i = 0; i < wake; ++i) {
+          cv_.notify_one();
         }
-      });
+      }
+    }
+  }
+
+  /**
+   * 任务进入哪个节点的队列：指定了 node 时取模；工作线程提交的留在本节点；
+   * 外部线程提交的在各节点间轮转。
+   */
+  int submit_node_locked(int node) {
+    int n = static_cast<int>(tasks_.size());
+    if (node >= 0) {
+      return node % n;
+    }
+    if (current_pool_ == this) {
+      return current_node_;
+    }
+    next_node_ = (next_node_ + 1) % n;
+    return next_node_;
+  }
+
+  /**
+   * 优先取本节点的任务，本节点没有任务时从积压最多的节点取。
+   * 因此优先级只在同一个节点的队列内部保证。
+   */
+  int pop_node_locked(int node) const {
+    if (!tasks_[node].empty()) {
+      return node;
+    }
+    int busiest = node;
+    for (int i = 0; i < static_cast<int>(tasks_.size()); ++i) {
+      if (tasks_[i].size() > tasks_[busiest].size()) {
+        busiest = i;
+      }
+    }
+    return busiest;
+  }
+
+  /**
+   * 需要唤醒的休眠线程数：正在自旋的线程会自己取到任务，只为多出来的任务唤醒。
+   */
+  int wakeups_locked() const {
+    long extra = static_cast<long>(queued_.load()) - spinning_.load();
+    return static_cast<int>(std::min<long>(sleepers_, std::max(0L, extra)));
+  }
+
+  /**
+   * 没有空闲线程且积压任务不少于线程数时，按 spawn_interval 限速新增线程。
+   * 工作线程每次取出任务后也会调用，所以必须检查 stop_：shutdown 开始后不再扩容。
+   */
+  void maybe_spawn_locked(Clock::time_point now) {
+    if (!stop_ && numThreads_ < max_threads_ && sleepers_ == 0 &&
+        spinning_ == 0 &&
+        queued_.load() >= static_cast<size_t>(numThreads_) &&
+        now - last_spawn_ >= spawn_interval_) {
+      spawn_locked();
+      last_spawn_ = now;
+    }
+  }
+
+  /**
+   * 新线程放到工作线程最少的节点上；pin_per_core 时再选该节点上线程最少的 CPU。
+   */
+  void spawn_locked() {
+    // shutdown（包括析构）已经取走了 workers_ 中要 join 的线程，
+    // 之后创建的线程不会被 join，线程对象析构时 std::terminate
+    if (stop_) {
+      return;
+    }
+    int id = next_worker_id_++;
+    Worker worker;
+    worker.counters.reset(new WorkerCounters);
+    worker.node = static_cast<int>(
+        std::min_element(node_workers_.begin(), node_workers_.end()) -
+        node_workers_.begin());
+    ++node_workers_[worker.node];
+    if (pin_per_core_) {
+      auto &load = cpu_workers_[worker.node];
+      worker.cpu_slot =
+          static_cast<int>(std::min_element(load.begin(), load.end()) -
+                           load.begin());
+      ++load[worker.cpu_slot];
+    }
+    int node = worker.node;
+    int cpu_slot = worker.cpu_slot;
+    WorkerCounters *counters = worker.counters.get();
+    ++numThreads_;
+    worker.thread = std::thread([this, id, node, cpu_slot, counters]() {
+      worker_loop(id, node, cpu_slot, *counters);
+    });
+    workers_.emplace(id, std::move(worker));
+  }
+
+  /**
+   * 当前线程退出线程池。线程对象保存在 last_retired_ 中，
+   * 由下一个退出的线程或析构函数负责 join。
+   */
+  void retire_locked(int id, std::unique_lock<std::mutex> &locker) {
+    std::thread prev = std::move(last_retired_);
+    auto it = workers_.find(id);
+    --node_workers_[it->second.node];
+    if (it->second.cpu_slot >= 0) {
+      --cpu_workers_[it->second.node][it->second.cpu_slot];
+    }
+    retired_tasks_ += it->second.counters->tasks.load();
+    last_retired_ = std::move(it->second.thread);
+    workers_.erase(it);
+    --numThreads_;
+    locker.unlock();
+    if (prev.joinable()) {
+      prev.join();
+    }
+  }
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  /**
+   * 休眠前先自旋等待一段时间。自旋等到了任务就加倍下次的自旋次数，否则减半。
+   */
+  void spin_wait(int &spin_limit) {
+    if (max_spin_ == 0) {
+      return;
+    }
+    spinning_.fetch_add(1);
+    int i = 0;
+    for (; i < spin_limit; ++i) {
+      if (queued_.load(std::memory_order_relaxed) > 0 || stop_) {
+        break;
+      }
+      cpu_relax();
+    }
+    spinning_.fetch_sub(1);
+    if (i < spin_limit) {
+      spin_limit = std::min(max_spin_, spin_limit * 2);
+    } else {
+      spin_limit = std::max(kMinSpin, spin_limit / 2);
+    }
+  }
+
+  void start(const ThreadPoolOptions &options) {
+    min_threads_ = std::max(1, options.min_threads);
+    max_threads_ = std::max(min_threads_, options.max_threads);
+    idle_timeout_ = options.idle_timeout;
+    spawn_interval_ = options.spawn_interval;
+    max_spin_ = std::max(0, options.max_spin);
+    max_queue_size_ = options.max_queue_size;
+    full_policy_ = options.full_policy;
+    init_placement(options);
+
+    std::unique_lock<std::mutex> locker(mtx_);
+    for (int i = 0; i < min_threads_; ++i) {
+      spawn_locked();
+    }
+  }
+
+  /**
+   * 按选项划分节点：numa_aware 时每个 NUMA 节点一组 CPU，否则只有一组。
+   * 一组 CPU 为空表示不绑定。
+   */
+  void init_placement(const ThreadPoolOptions &options) {
+    pin_per_core_ = options.pin_per_core;
+    if (options.numa_aware) {
+      node_cpus_ = CpuTopology::detect(options.cpus).nodes;
+    } else if (!options.cpus.empty()) {
+      node_cpus_.push_back(options.cpus);
+    } else {
+      node_cpus_.push_back(pin_per_core_ ? allowed_cpus() : std::vector<int>());
+    }
+    int n = static_cast<int>(node_cpus_.size());
+    tasks_ = std::vector<PriorityTaskQueue>(n);
+    node_workers_.assign(n, 0);
+    cpu_workers_.resize(n);
+    for (int i = 0; i < n; ++i) {
+      cpu_workers_[i].assign(node_cpus_[i].size(), 0);
+    }
+  }
+
+  void worker_loop(int id, int node, int cpu_slot,
+                   WorkerCounters &counters) {
+    if (cpu_slot >= 0) {
+      set_thread_affinity({node_cpus_[node][cpu_slot]});
+    } else if (!node_cpus_[node].empty()) {
+      set_thread_affinity(node_cpus_[node]);
+    }
+    current_pool_ = this;
+    current_node_ = node;
+
+    int spin_limit = max_spin_;
+    while (true) {
+      spin_wait(spin_limit);
+
+      ScheduledTask task;
+      Clock::time_point now;
+      int source;
+      {
+        std::unique_lock<std::mutex> locker(mtx_);
+        auto idle_deadline = Clock::now() + idle_timeout_;
+        // stop_为true、任务队列不为空或需要减少线程时，不应该被阻塞
+        while (!stop_ && retire_requests_ == 0 && queued_ == 0) {
+          ++sleepers_;
+          bool timeout =
+              cv_.wait_until(locker, idle_deadline) == std::cv_status::timeout;
+          --sleepers_;
+          if (!timeout) {
+            continue;
+          }
+          if (!stop_ && queued_ == 0 &&
+              numThreads_ - retire_requests_ > min_threads_) {
+            retire_locked(id, locker);
+            return;
+          }
+          idle_deadline = Clock::now() + idle_timeout_;
+        }
+        if (!stop_ && retire_requests_ > 0) {
+          --retire_requests_;
+          retire_locked(id, locker);
+          return;
+        }
+        if (stop_ && queued_ == 0) {
+          return;
+        }
+
+        now = Clock::now();
+        source = pop_node_locked(node);
+        task = tasks_[source].pop(now);
+        --queued_;
+        if (blocked_producers_ > 0) {
+          not_full_cv_.notify_one();
+        }
+        // 积压持续存在时，由工作线程继续扩容
+        maybe_spawn_locked(now);
+      }
+
+      if (task.has_deadline() && now > task.deadline) {
+        // 过期任务直接析构，其 promise 析构后 future 得到 broken_promise
+        tasks_[source].record_expired(task.priority);
+        continue;
+      }
+      if (task.token.cancelled()) {
+        tasks_[source].record_cancelled(task.priority);
+        continue;
+      }
+      task.task();
+#if THREADPOOL_METRICS
+      // 以出队时间作为开始时间，省去一次读时钟
+      auto run = Clock::now() - now;
+      run_time_.record(run);
+      counters.tasks.fetch_add(1, std::memory_order_relaxed);
+      counters.busy_ns.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(run).count(),
+          std::memory_order_relaxed);
+      if (source != node) {
+        steals_.fetch_add(1, std::memory_order_relaxed);
+      }
+#else
+      (void)counters;
+#endif
     }
   }
 
  private:
-  std::vector<std::thread> pool_;
-  std::queue<Task> tasks_;
-  std::mutex mtx_;
+  static constexpr int kMinSpin = 16;
+  // commit_bulk/post_bulk 每次加锁最多入队的任务数
+  static constexpr size_t kBulkBatch = 256;
+
+  struct Worker {
+    std::thread thread;
+    std::unique_ptr<WorkerCounters> counters;
+    int node = 0;
+    int cpu_slot = -1;  // 在 node_cpus_[node] 中的下标，-1 表示不绑定单个 CPU
+  };
+
+  inline static thread_local ThreadPool *current_pool_ = nullptr;
+  inline static thread_local int current_node_ = 0;
+
+  // 启动后不再改变
+  std::vector<std::vector<int>> node_cpus_;
+  bool pin_per_core_ = false;
+
+  // 以下成员由 mtx_ 保护
+  std::unordered_map<int, Worker> workers_;
+  std::thread last_retired_;
+  int next_worker_id_ = 0;
+  int retire_requests_ = 0;
+  int sleepers_ = 0;
+  int min_threads_ = 1;
+  int max_threads_ = 1;
+  Clock::time_point last_spawn_;
+  std::vector<PriorityTaskQueue> tasks_;  // 每个节点一个
+  std::vector<int> node_workers_;
+  std::vector<std::vector<int>> cpu_workers_;
+  int next_node_ = 0;
+  int blocked_producers_ = 0;
+  uint64_t retired_tasks_ = 0;
+
+  std::chrono::milliseconds idle_timeout_{5000};
+  std::chrono::microseconds spawn_interval_{1000};
+  int max_spin_ = 0;
+  size_t max_queue_size_ = 0;
+  QueueFullPolicy full_policy_ = QueueFullPolicy::kBlock;
+
+  LatencyHistogram run_time_;
+  std::atomic<uint64_t> wakeups_{0};
+  std::atomic<uint64_t> steals_{0};
+
+  mutable std::mutex mtx_;
   std::condition_variable cv_;
+  std::condition_variable not_full_cv_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<int> spinning_{0};
   std::atomic<int> numThreads_;
   std::atomic<bool> stop_;
 };
@@ -0,0 +1,267 @@
+#ifndef THREAD_POOL_V2_H
+#define THREAD_POOL_V2_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "task.h"
+
+/**
+ * 基于工作窃取（work stealing）的线程池，接口与 ThreadPool 保持一致。
+ *
+ * 每个工作线程拥有一个本地双端队列：
+ *  - 工作线程内部提交的任务压入自己队列的尾部，并从尾部取出（LIFO，缓存友好）；
+ *  - 外部线程提交的任务进入全局队列；
+ *  - 本地队列和全局队列都为空时，从其他线程队列的头部窃取任务。
+ * 这样提交和取任务大多只竞争各自队列的锁，而不是所有线程共用一把锁。
+ */
+class WorkStealingThreadPool {
+ public:
+  using Task = MoveOnlyTask;
+
+  WorkStealingThreadPool(int numThreads = std::thread::hardware_concurrency())
+      : stop_(false) {
+    int num = std::max(1u, std::thread::hardware_concurrency());
+    numThreads_ = std::max(1, numThreads > num ? num : numThreads);
+    start();
+  }
+
+  ~WorkStealingThreadPool() {
+    {
+      std::unique_lock<std::mutex> locker(sleep_mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : pool_) {
+      if (t.joinable()) {
+        t.join();
+      }
+    }
+  }
+
+  WorkStealingThreadPool(const WorkStealingThreadPool &) = delete;
+  WorkStealingThreadPool &operator=(const WorkStealingThreadPool &) = delete;
+
+  template <class F, class... Args>
+  auto commit_task(F &&f, Args &&...args) -> std::future<decltype(f(args...))> {
+    if (stop_) {
+      throw std::runtime_error("commit task on stopped ThreadPool.");
+    }
+
+    using return_type = decltype(f(args...));
+    auto promise = make_pooled_promise<return_type>();
+    auto ret = promise.get_future();
+    enqueue(make_promise_task(std::move(promise), std::forward<F>(f),
+                              std::forward<Args>(args)...));
+    return ret;
+  }
+
+  /**
+   * 提交不需要返回值的任务，不创建 future。
+   * 任务抛出的异常不会被捕获，会导致 std::terminate。
+   */
+  template <class F, class... Args>
+  void post(F &&f, Args &&...args) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue(make_task(std::forward<F>(f), std::forward<Args>(args)...));
+  }
+
+  /**
+   * 对 [first, last) 中的每个元素提交 fn(*it)。任务直接构造到队列中，
+   * 每 kBulkBatch 个任务加一次锁，批与批之间唤醒工作线程。
+   */
+  template <class InputIt, class F>
+  auto commit_bulk(InputIt first, InputIt last, F fn)
+      -> std::vector<std::future<decltype(fn(*first))>> {
+    if (stop_) {
+      throw std::runtime_error("commit task on stopped ThreadPool.");
+    }
+
+    using return_type = decltype(fn(*first));
+    std::vector<std::future<return_type>> ret;
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+      ret.reserve(std::distance(first, last));
+    }
+    enqueue_bulk(first, last, [&ret, &fn](auto &&value) {
+      auto promise = make_pooled_promise<return_type>();
+      ret.emplace_back(promise.get_future());
+      return make_promise_task(std::move(promise), fn,
+                               std::forward<decltype(value)>(value));
+    });
+    return ret;
+  }
+
+  /**
+   * commit_bulk 的无返回值版本。
+   */
+  template <class InputIt, class F>
+  void post_bulk(InputIt first, InputIt last, F fn) {
+    if (stop_) {
+      throw std::runtime_error("post task on stopped ThreadPool.");
+    }
+    enqueue_bulk(first, last, [&fn](auto &&value) {
+      return make_task(fn, std::forward<decltype(value)>(value));
+    });
+  }
+
+  int size() const { return numThreads_; }
+
+ private:
+  struct alignas(64) WorkQueue {
+    std::mutex mtx;
+    TaskQueue tasks;
+  };
+
+  void start() {
+    for (int i = 0; i < numThreads_; ++i) {
+      queues_.emplace_back(new WorkQueue);
+    }
+    for (int i = 0; i < numThreads_; ++i) {
+      pool_.emplace_back([this, i]() { worker_loop(i); });
+    }
+  }
+
+  // 工作线程内提交的任务放入自己的本地队列，其他线程提交的放入全局队列
+  WorkQueue &submit_queue() {
+    return current_pool_ == this ? *queues_[current_index_] : global_;
+  }
+
+  void enqueue(Task task) {
+    WorkQueue &q = submit_queue();
+    {
+      std::unique_lock<std::mutex> locker(q.mtx);
+      q.tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1);
+    wakeup(1);
+  }
+
+  /**
+   * 把 make(*it) 返回的任务逐批构造到提交队列中，每批只加一次锁。
+   * make 抛出异常时已经入队的任务保留，唤醒工作线程后重新抛出。
+   */
+  template <class InputIt, class MakeTask>
+  void enqueue_bulk(InputIt first, InputIt last, MakeTask make) {
+    WorkQueue &q = submit_queue();
+    while (first != last) {
+      int pushed = 0;
+      try {
+        std::unique_lock<std::mutex> locker(q.mtx);
+        for (; pushed < kBulkBatch && first != last; ++pushed, ++first) {
+          q.tasks.push_back(make(*first));
+        }
+      } catch (...) {
+        pending_.fetch_add(pushed);
+        wakeup(pushed);
+        throw;
+      }
+      pending_.fetch_add(pushed);
+      wakeup(pushed);
+    }
+  }
+
+  void wakeup(int n) {
+    int sleeping = sleeping_.load();
+    if (sleeping == 0) {
+      return;
+    }
+    // 持锁再通知，避免与正在进入等待的工作线程之间丢失唤醒
+    std::unique_lock<std::mutex> locker(sleep_mtx_);
+    if (n >= sleeping) {
+      cv_.notify_all();
+    } else {
+      for (int i = 0; i < n; ++i) {
+        cv_.notify_one();
+      }
+    }
+  }
+
+  bool pop_local(int index, Task &task) {
+    WorkQueue &q = *queues_[index];
+    std::unique_lock<std::mutex> locker(q.mtx);
+    if (q.tasks.empty()) {
+      return false;
+    }
+    task = q.tasks.pop_back();
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  bool pop_global(Task &task) {
+    std::unique_lock<std::mutex> locker(global_.mtx);
+    if (global_.tasks.empty()) {
+      return false;
+    }
+    task = global_.tasks.pop_front();
+    pending_.fetch_sub(1);
+    return true;
+  }
+
+  bool steal(int index, Task &task) {
+    for (int i = 1; i < numThreads_; ++i) {
+      WorkQueue &q = *queues_[(index + i) % numThreads_];
+      std::unique_lock<std::mutex> locker(q.mtx, std::try_to_lock);
+      if (!locker.owns_lock() || q.tasks.empty()) {
+        continue;
+      }
+      task = q.tasks.pop_front();
+      pending_.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  void worker_loop(int index) {
+    current_pool_ = this;
+    current_index_ = index;
+
+    Task task;
+    while (true) {
+      if (pop_local(index, task) || pop_global(task) || steal(index, task)) {
+        task();
+        task.reset();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> locker(sleep_mtx_);
+      if (stop_ && pending_.load() == 0) {
+        return;
+      }
+      sleeping_.fetch_add(1);
+      cv_.wait(locker, [this]() { return stop_ || pending_.load() > 0; });
+      sleeping_.fetch_sub(1);
+    }
+  }
+
+ private:
+  // commit_bulk/post_bulk 每次加锁最多入队的任务数
+  static constexpr int kBulkBatch = 256;
+
+  inline static thread_local WorkStealingThreadPool *current_pool_ = nullptr;
+  inline static thread_local int current_index_ = 0;
+
+  std::vector<std::thread> pool_;
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  WorkQueue global_;
+  std::mutex sleep_mtx_;
+  std::condition_variable cv_;
+  std::atomic<int> pending_{0};
+  std::atomic<int> sleeping_{0};
+  int numThreads_;
+  std::atomic<bool> stop_;
+};
+
+#endif /* THREAD_POOL_V2_H */
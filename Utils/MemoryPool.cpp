@@ -0,0 +1,141 @@
+#include "MemoryPool.h"
+
+#include <algorithm>
+
+namespace cpptools {
+
+namespace {
+
+// 单个内存块的上限，更大的请求单独申请一块
+constexpr size_t kMaxChunkSize = 1 << 20;
+
+}  // namespace
+
+MonotonicArena::MonotonicArena(size_t initial_size,
+                               std::pmr::memory_resource *upstream)
+    : upstream_(upstream), next_size_(std::max<size_t>(initial_size, 64)) {}
+
+MonotonicArena::~MonotonicArena() { release(); }
+
+void *MonotonicArena::allocate_slow(size_t bytes, size_t alignment) {
+  // 先尝试 reset 之前留下的内存块
+  while (current_ + 1 < chunks_.size()) {
+    ++current_;
+    ptr_ = chunks_[current_].data;
+    end_ = ptr_ + chunks_[current_].size;
+    uintptr_t p = (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) &
+                  ~(uintptr_t(alignment) - 1);
+    if (p + bytes <= reinterpret_cast<uintptr_t>(end_)) {
+      ptr_ = reinterpret_cast<char *>(p + bytes);
+      return reinterpret_cast<void *>(p);
+    }
+  }
+
+  size_t size = std::max(next_size_, bytes + alignment);
+  // 先扩容，保证申请到的内存块一定能记录下来
+  if (chunks_.size() == chunks_.capacity()) {
+    chunks_.reserve(2 * chunks_.size() + 1);
+  }
+  char *data = static_cast<char *>(
+      upstream_->allocate(size, alignof(std::max_align_t)));
+  chunks_.push_back({data, size});
+  current_ = chunks_.size() - 1;
+  reserved_ += size;
+  next_size_ = std::min(next_size_ * 2, kMaxChunkSize);
+
+  uintptr_t p = (reinterpret_cast<uintptr_t>(data) + alignment - 1) &
+                ~(uintptr_t(alignment) - 1);
+  ptr_ = reinterpret_cast<char *>(p + bytes);
+  end_ = data + size;
+  return reinterpret_cast<void *>(p);
+}
+
+void MonotonicArena::reset() {
+  current_ = 0;
+  if (chunks_.empty()) {
+    ptr_ = end_ = nullptr;
+  } else {
+    ptr_ = chunks_[0].data;
+    end_ = ptr_ + chunks_[0].size;
+  }
+}
+
+void MonotonicArena::release() {
+  for (const Chunk &chunk : chunks_) {
+    upstream_->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+  }
+  chunks_.clear();
+  current_ = 0;
+  reserved_ = 0;
+  ptr_ = end_ = nullptr;
+}
+
+size_t MonotonicArena::bytes_used() const {
+  size_t used = 0;
+  for (size_t i = 0; i < current_; ++i) {
+    used += chunks_[i].size;
+  }
+  if (!chunks_.empty()) {
+    used += ptr_ - chunks_[current_].data;
+  }
+  return used;
+}
+
+SlabResource::SlabResource(std::pmr::memory_resource *upstream)
+    : upstream_(upstream) {}
+
+SlabResource::~SlabResource() { release(); }
+
+void SlabResource::release() {
+  for (void *slab : slabs_) {
+    upstream_->deallocate(slab, kSlabSize, kMaxBlockSize);
+  }
+  slabs_.clear();
+  classes_.fill(SizeClass());
+}
+
+void *SlabResource::do_allocate(size_t bytes, size_t alignment) {
+  int index = class_of(bytes, alignment);
+  if (index == kNumClasses) {
+    return upstream_->allocate(bytes, alignment);
+  }
+  SizeClass &cls = classes_[index];
+  if (cls.free != nullptr) {
+    FreeBlock *block = cls.free;
+    cls.free = block->next;
+    return block;
+  }
+  size_t size = kMinBlockSize << index;
+  if (cls.ptr == cls.end) {
+    refill(index);
+  }
+  void *p = cls.ptr;
+  cls.ptr += size;
+  return p;
+}
+
+void SlabResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+  int index = class_of(bytes, alignment);
+  if (index == kNumClasses) {
+    upstream_->deallocate(p, bytes, alignment);
+    return;
+  }
+  SizeClass &cls = classes_[index];
+  FreeBlock *block = static_cast<FreeBlock *>(p);
+  block->next = cls.free;
+  cls.free = block;
+}
+
+void SlabResource::refill(int index) {
+  // slab 按 4KB 对齐，切出的块按自身大小对齐
+  if (slabs_.size() == slabs_.capacity()) {
+    slabs_.reserve(2 * slabs_.size() + 1);
+  }
+  char *slab =
+      static_cast<char *>(upstream_->allocate(kSlabSize, kMaxBlockSize));
+  slabs_.push_back(slab);
+  classes_[index].ptr = slab;
+  classes_[index].end = slab + kSlabSize;
+}
+
+}  // namespace cpptools
@@ -0,0 +1,248 @@
+#ifndef MEMORY_POOL_H_
+#define MEMORY_POOL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace cpptools {
+
+// 固定大小对象的线程局部缓存池。
+//
+// destroy 后的内存块放进当前线程的空闲链表，下次 create 直接取出，
+// 热路径上没有锁也不进入 malloc。每个块单独分配，可以在一个线程 create、
+// 在另一个线程 destroy；每个线程最多缓存 MaxCached 个块，多余的直接释放，
+// 线程退出时释放本线程缓存的块。
+template <typename T, size_t MaxCached = 4096>
+class ObjectPool {
+ public:
+  struct Deleter {
+    void operator()(T *p) const { ObjectPool::destroy(p); }
+  };
+
+  using Ptr = std::unique_ptr<T, Deleter>;
+
+  template <typename... Args>
+  static T *create(Args &&...args) {
+    Cache &cache = local();
+    Block *block = cache.head;
+    if (block != nullptr) {
+      cache.head = block->next;
+      --cache.count;
+    } else {
+      block = new Block;
+    }
+    try {
+      return new (block->storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+      recycle(cache, block);
+      throw;
+    }
+  }
+
+  static void destroy(T *p) {
+    if (p == nullptr) {
+      return;
+    }
+    p->~T();
+    recycle(local(), reinterpret_cast<Block *>(p));
+  }
+
+  template <typename... Args>
+  static Ptr make(Args &&...args) {
+    return Ptr(create(std::forward<Args>(args)...));
+  }
+
+  // 当前线程缓存的空闲块数。
+  static size_t cached() { return local().count; }
+
+  // 释放当前线程缓存的所有空闲块。
+  static void trim() { local().trim(); }
+
+ private:
+  union Block {
+    Block *next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  struct Cache {
+    Block *head = nullptr;
+    size_t count = 0;
+
+    void trim() {
+      while (head != nullptr) {
+        Block *next = head->next;
+        delete head;
+        head = next;
+      }
+      count = 0;
+    }
+
+    ~Cache() { trim(); }
+  };
+
+  static Cache &local() {
+    thread_local Cache cache;
+    return cache;
+  }
+
+  static void recycle(Cache &cache, Block *block) {
+    if (cache.count >= MaxCached) {
+      delete block;
+      return;
+    }
+    block->next = cache.head;
+    cache.head = block;
+    ++cache.count;
+  }
+};
+
+// 单调增长的内存区：分配只是移动指针，deallocate 什么也不做，
+// 调用 reset 后一次性回收全部内存，已申请的内存块保留下来供下一轮使用。
+// 适合每处理一帧 / 一个事件就整体丢弃的临时数据，例如
+//   std::pmr::vector<float> chunk(&arena);
+// 不是线程安全的。
+class MonotonicArena : public std::pmr::memory_resource {
+ public:
+  explicit MonotonicArena(
+      size_t initial_size = 4096,
+      std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+  ~MonotonicArena() override;
+
+  MonotonicArena(const MonotonicArena &) = delete;
+  MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+  // 不经过虚函数的分配接口，与 allocate 等价。
+  void *bump(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) &
+                  ~(uintptr_t(alignment) - 1);
+    if (ptr_ != nullptr && p + bytes <= reinterpret_cast<uintptr_t>(end_)) {
+      ptr_ = reinterpret_cast<char *>(p + bytes);
+      return reinterpret_cast<void *>(p);
+    }
+    return allocate_slow(bytes, alignment);
+  }
+
+  // 在内存区中构造对象，对象的析构函数不会被调用，只适合平凡析构的类型。
+  template <typename T, typename... Args>
+  T *create(Args &&...args) {
+    return new (bump(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  // 之前分配的内存全部失效，保留已申请的内存块。
+  void reset();
+
+  // 把所有内存块还给上游。
+  void release();
+
+  // 本轮已经用掉的字节数，包括对齐和内存块尾部放不下而浪费的空间。
+  size_t bytes_used() const;
+
+  // 从上游申请的总字节数。
+  size_t bytes_reserved() const { return reserved_; }
+
+ protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    return bump(bytes, alignment);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+ private:
+  struct Chunk {
+    char *data;
+    size_t size;
+  };
+
+  void *allocate_slow(size_t bytes, size_t alignment);
+
+  std::pmr::memory_resource *upstream_;
+  std::vector<Chunk> chunks_;
+  size_t current_ = 0;
+  size_t next_size_;
+  size_t reserved_ = 0;
+  char *ptr_ = nullptr;
+  char *end_ = nullptr;
+};
+
+// 按大小分级的 slab 分配器。
+//
+// 8 字节到 4KB 按 2 的幂分为 10 级，每级从 64KB 的 slab 中切出等大的块，
+// 释放的块挂到该级的空闲链表上，分配和释放都是 O(1)，同一级的块在内存中相邻。
+// 超过 4KB 或对齐要求超过 4KB 的请求直接交给上游。
+// 与 std::pmr::unsynchronized_pool_resource 一样不是线程安全的，
+// 内存只在 release 或析构时还给上游。
+class SlabResource : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t kMinBlockSize = 8;
+  static constexpr size_t kMaxBlockSize = 4096;
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  explicit SlabResource(
+      std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+  ~SlabResource() override;
+
+  SlabResource(const SlabResource &) = delete;
+  SlabResource &operator=(const SlabResource &) = delete;
+
+  void release();
+
+  // 从上游申请的 slab 总字节数，不含直接转交上游的大块。
+  size_t bytes_reserved() const { return slabs_.size() * kSlabSize; }
+
+ protected:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+ private:
+  static constexpr int kNumClasses = 10;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct SizeClass {
+    FreeBlock *free = nullptr;
+    // 当前 slab 中还没切出去的部分
+    char *ptr = nullptr;
+    char *end = nullptr;
+  };
+
+  // 能同时满足大小和对齐的最小级别，超出范围时返回 kNumClasses。
+  static int class_of(size_t bytes, size_t alignment) {
+    size_t size = bytes > alignment ? bytes : alignment;
+    if (size > kMaxBlockSize) {
+      return kNumClasses;
+    }
+    if (size <= kMinBlockSize) {
+      return 0;
+    }
+    return 64 - __builtin_clzll(size - 1) - 3;
+  }
+
+  void refill(int index);
+
+  std::pmr::memory_resource *upstream_;
+  std::array<SizeClass, kNumClasses> classes_;
+  std::vector<void *> slabs_;
+};
+
+}  // namespace cpptools
+
+#endif  // MEMORY_POOL_H_
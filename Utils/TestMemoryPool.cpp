@@ -0,0 +1,317 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MemoryPool.h"
+
+using cpptools::MonotonicArena;
+using cpptools::ObjectPool;
+using cpptools::SlabResource;
+
+// 大小与 PacketInfo 的元数据部分相当
+struct Packet {
+  uint64_t sequence = 0;
+  uint64_t received_ns = 0;
+  uint32_t size = 0;
+  char header[44] = {};
+};
+
+void TestMemoryPool() {
+  auto a = ObjectPool<Packet>::make();
+  Packet *first = a.get();
+  a.reset();
+  auto b = ObjectPool<Packet>::make();
+  std::cout << "ObjectPool reuses block: " << (b.get() == first)
+            << ", cached = " << ObjectPool<Packet>::cached() << std::endl;
+
+  MonotonicArena arena(256);
+  bool aligned = true;
+  for (int round = 0; round < 3; ++round) {
+    std::pmr::vector<float> chunk(&arena);
+    for (int i = 0; i < 1000; ++i) {
+      chunk.push_back(i);
+    }
+    for (size_t alignment = 1; alignment <= 256; alignment *= 2) {
+      auto p = reinterpret_cast<uintptr_t>(arena.allocate(3, alignment));
+      aligned = aligned && p % alignment == 0;
+    }
+    if (round < 2) {
+      arena.reset();
+    }
+  }
+  std::cout << "MonotonicArena aligned = " << aligned
+            << ", reserved = " << arena.bytes_reserved()
+            << ", used = " << arena.bytes_used() << std::endl;
+
+  SlabResource slab;
+  std::mt19937 rng(1);
+  std::vector<std::pair<void *, size_t>> blocks;
+  for (int i = 0; i < 100000; ++i) {
+    if (!blocks.empty() && rng() % 2 == 0) {
+      size_t k = rng() % blocks.size();
+      slab.deallocate(blocks[k].first, blocks[k].second);
+      blocks[k] = blocks.back();
+      blocks.pop_back();
+    } else {
+      size_t size = 1 + rng() % 6000;
+      void *p = slab.allocate(size);
+      aligned = aligned &&
+                reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t) == 0;
+      std::fill_n(static_cast<char *>(p), size, 0x5a);
+      blocks.push_back({p, size});
+    }
+  }
+  for (auto &block : blocks) {
+    slab.deallocate(block.first, block.second);
+  }
+  std::cout << "SlabResource aligned = " << aligned
+            << ", reserved = " << slab.bytes_reserved() << std::endl;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string benchmark;
+  std::string allocator;
+  uint64_t ops = 0;
+  double seconds = 0;
+  // 负载稳定时（释放前）的常驻内存减去开始时的常驻内存
+  long rss_kb = 0;
+
+  double allocs_per_sec() const { return seconds > 0 ? ops / seconds : 0; }
+};
+
+long current_rss_kb() {
+  long pages = 0;
+  long resident = 0;
+  FILE *f = std::fopen("/proc/self/statm", "r");
+  if (f != nullptr) {
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    std::fclose(f);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 各负载在释放全部内存之前记录一次常驻内存
+long g_steady_rss_kb = 0;
+
+void SampleRss() { g_steady_rss_kb = current_rss_kb(); }
+
+/**
+ * 在子进程中运行 workload，每个分配器的 RSS 互不影响
+ * （malloc 释放的内存通常不还给系统，同一进程里先后测量会互相干扰）。
+ */
+template <typename Workload>
+Result RunIsolated(const std::string &benchmark, const std::string &allocator,
+                   Workload workload) {
+  Result r{benchmark, allocator};
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return r;
+  }
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    long rss_before = current_rss_kb();
+    auto start = Clock::now();
+    uint64_t ops = workload();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    char line[128];
+    int n = std::snprintf(line, sizeof(line), "%llu %.9f %ld",
+                          static_cast<unsigned long long>(ops), seconds,
+                          g_steady_rss_kb - rss_before);
+    ssize_t written = write(fds[1], line, n);
+    _exit(written == n ? 0 : 1);
+  }
+  close(fds[1]);
+  char line[128] = {};
+  ssize_t n = read(fds[0], line, sizeof(line) - 1);
+  close(fds[0]);
+  waitpid(pid, nullptr, 0);
+  if (n > 0) {
+    unsigned long long ops = 0;
+    std::sscanf(line, "%llu %lf %ld", &ops, &r.seconds, &r.rss_kb);
+    r.ops = ops;
+  }
+  return r;
+}
+
+/**
+ * object：live 个对象组成环，每次销毁最旧的一个再创建一个，与按事件分配 PacketInfo 相同。
+ */
+template <typename Create, typename Destroy>
+uint64_t ObjectWorkload(uint64_t ops, size_t live, Create create,
+                        Destroy destroy) {
+  std::vector<Packet *> ring(live, nullptr);
+  uint64_t checksum = 0;
+  for (uint64_t i = 0; i < ops; ++i) {
+    Packet *&slot = ring[i % live];
+    if (slot != nullptr) {
+      checksum += slot->sequence;
+      destroy(slot);
+    }
+    slot = create();
+    slot->sequence = i;
+  }
+  SampleRss();
+  for (Packet *p : ring) {
+    destroy(p);
+  }
+  return checksum == 42 ? 0 : ops;
+}
+
+/**
+ * window：每个窗口分配若干个 512 个 float 的缓冲区和一些小对象，窗口结束时全部丢弃，
+ * 与 VadIterator::process 中每个窗口一个 chunk 的模式相同。
+ */
+template <typename MakeResource, typename EndWindow>
+uint64_t WindowWorkload(uint64_t ops, MakeResource resource,
+                        EndWindow end_window) {
+  constexpr int kPerWindow = 16;
+  uint64_t done = 0;
+  float checksum = 0;
+  while (done < ops) {
+    {
+      std::pmr::memory_resource *mr = resource();
+      std::pmr::vector<std::pmr::vector<float>> buffers(mr);
+      buffers.reserve(kPerWindow);
+      for (int i = 0; i < kPerWindow; ++i) {
+        // 内层 vector 通过 uses-allocator 构造同样使用 mr
+        buffers.emplace_back(i % 4 == 0 ? 512 : 16, 1.0f);
+        checksum += buffers.back()[0];
+      }
+      done += kPerWindow + 1;
+      if (done >= ops) {
+        SampleRss();
+      }
+    }
+    end_window();
+  }
+  return checksum == 42 ? 0 : done;
+}
+
+/**
+ * mixed：大小在 8B~1KB 之间（偏向小块）的 live 个块随机替换。
+ */
+uint64_t MixedWorkload(uint64_t ops, size_t live,
+                       std::pmr::memory_resource *mr) {
+  std::mt19937 rng(3);
+  std::vector<std::pair<void *, size_t>> blocks(live, {nullptr, 0});
+  std::vector<uint32_t> picks(1 << 16);
+  std::vector<uint32_t> sizes(1 << 16);
+  for (size_t i = 0; i < picks.size(); ++i) {
+    picks[i] = rng() % live;
+    sizes[i] = 8u << (rng() % 8) >> (rng() % 2);
+  }
+  for (uint64_t i = 0; i < ops; ++i) {
+    auto &block = blocks[picks[i & 0xffff]];
+    if (block.first != nullptr) {
+      mr->deallocate(block.first, block.second);
+    }
+    block.second = sizes[(i * 7) & 0xffff];
+    block.first = mr->allocate(block.second);
+    static_cast<char *>(block.first)[0] = 1;
+  }
+  SampleRss();
+  for (auto &block : blocks) {
+    if (block.first != nullptr) {
+      mr->deallocate(block.first, block.second);
+    }
+  }
+  return ops;
+}
+
+void print(const Result &r, bool json) {
+  if (json) {
+    std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"allocator\":\""
+              << r.allocator << "\",\"ops\":" << r.ops
+              << ",\"seconds\":" << r.seconds
+              << ",\"allocs_per_sec\":" << r.allocs_per_sec()
+              << ",\"rss_kb\":" << r.rss_kb << "}" << std::endl;
+  } else {
+    std::cout << r.benchmark << "," << r.allocator << "," << r.ops << ","
+              << r.seconds << "," << r.allocs_per_sec() << "," << r.rss_kb
+              << std::endl;
+  }
+}
+
+/**
+ *   ./TestMemoryPool [--json] [--ops=N] [--live=N]
+ * 比较 ObjectPool、MonotonicArena、SlabResource 与 malloc
+ * （以及 std::pmr::unsynchronized_pool_resource）的分配速度和常驻内存。
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  uint64_t ops = 10000000;
+  size_t live = 4096;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      json = true;
+    } else if (arg.rfind("--ops=", 0) == 0) {
+      ops = std::max<uint64_t>(1, std::stoull(arg.substr(6)));
+    } else if (arg.rfind("--live=", 0) == 0) {
+      live = std::max<size_t>(1, std::stoull(arg.substr(7)));
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--json] [--ops=N] [--live=N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  if (!json) {
+    TestMemoryPool();
+    std::cout << "benchmark,allocator,ops,seconds,allocs_per_sec,rss_kb"
+              << std::endl;
+  }
+
+  std::vector<Result> results;
+  results.push_back(RunIsolated("object", "malloc", [&]() {
+    return ObjectWorkload(
+        ops, live, []() { return new Packet(); }, [](Packet *p) { delete p; });
+  }));
+  results.push_back(RunIsolated("object", "ObjectPool", [&]() {
+    return ObjectWorkload(
+        ops, live, []() { return ObjectPool<Packet>::create(); },
+        [](Packet *p) { ObjectPool<Packet>::destroy(p); });
+  }));
+
+  results.push_back(RunIsolated("window", "malloc", [&]() {
+    return WindowWorkload(
+        ops, []() { return std::pmr::new_delete_resource(); }, []() {});
+  }));
+  results.push_back(RunIsolated("window", "MonotonicArena", [&]() {
+    MonotonicArena arena;
+    return WindowWorkload(
+        ops, [&arena]() { return &arena; }, [&arena]() { arena.reset(); });
+  }));
+
+  results.push_back(RunIsolated("mixed", "malloc", [&]() {
+    return MixedWorkload(ops, live, std::pmr::new_delete_resource());
+  }));
+  results.push_back(RunIsolated("mixed", "SlabResource", [&]() {
+    SlabResource slab;
+    return MixedWorkload(ops, live, &slab);
+  }));
+  results.push_back(RunIsolated("mixed", "unsynchronized_pool", [&]() {
+    std::pmr::unsynchronized_pool_resource pool;
+    return MixedWorkload(ops, live, &pool);
+  }));
+
+  for (const auto &r : results) {
+    print(r, json);
+  }
+}